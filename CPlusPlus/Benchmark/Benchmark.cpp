@@ -0,0 +1,1091 @@
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "BoundedQueue.h"
+#include "ParallelAlgorithms.h"
+#include "TaskGraph.h"
+
+using namespace std;
+
+namespace utils
+{
+	namespace thread_management
+	{
+		namespace
+		{
+			const wchar_t BenchmarkPoolName[] = L"benchmark";
+
+			double ElapsedNanoseconds(const chrono::steady_clock::time_point& start, const chrono::steady_clock::time_point& end)
+			{
+				return chrono::duration<double, nano>(end - start).count();
+			}
+
+			//Mean, percentiles and max of the samples, which get sorted.
+			void AddDistribution(BenchmarkResult& result, vector<double>& samples)
+			{
+				result.Add("samples", static_cast<double>(samples.size()));
+				if (samples.empty())
+				{
+					return;
+				}
+
+				sort(samples.begin(), samples.end());
+				auto percentile = [&samples](const double& rank) { return samples[min(samples.size() - 1, static_cast<size_t>(rank * samples.size()))]; };
+
+				double sum = 0;
+				for (auto sample : samples)
+				{
+					sum += sample;
+				}
+
+				result.Add("meanNs", sum / samples.size());
+				result.Add("p50Ns", percentile(0.5));
+				result.Add("p90Ns", percentile(0.9));
+				result.Add("p99Ns", percentile(0.99));
+				result.Add("p999Ns", percentile(0.999));
+				result.Add("maxNs", samples.back());
+			}
+
+			//Distribution of the samples, which get sorted, and the mean divided over the edges of the graph.
+			void AddEdgeDistribution(BenchmarkResult& result, vector<double>& samples, const unsigned int& edges)
+			{
+				result.Add("edges", edges);
+				if (!samples.empty())
+				{
+					result.Add("nsPerEdge", accumulate(samples.begin(), samples.end(), 0.0) / samples.size() / max(1u, edges));
+				}
+				AddDistribution(result, samples);
+			}
+
+			//Ways of handing a callable to the pool that are compared side by side
+			enum IntakeCall
+			{
+				EnqueueCall,
+				PostCall,
+				SubmitCall
+			};
+
+			const IntakeCall IntakeCalls[] = { EnqueueCall, PostCall, SubmitCall };
+
+			string GetIntakeCallName(const IntakeCall& call)
+			{
+				switch (call)
+				{
+				case EnqueueCall:
+					return "task";
+				case PostCall:
+					return "post";
+				default:
+					return "submit";
+				}
+			}
+
+			//Enqueue wraps the function in a Task, Submit leaves the future to the caller, dropping it does not wait.
+			template <typename F>
+			void CallPool(ThreadPool& pool, const IntakeCall& call, F&& function)
+			{
+				switch (call)
+				{
+				case EnqueueCall:
+					pool.Enqueue(make_shared<Task>(forward<F>(function)));
+					break;
+				case PostCall:
+					pool.Post(forward<F>(function));
+					break;
+				default:
+					pool.Submit(forward<F>(function));
+					break;
+				}
+			}
+
+			void WaitForExecuted(const ThreadPool& pool, const unsigned long long& count)
+			{
+				while (pool.GetExecutedTaskCount() < count)
+				{
+					this_thread::yield();
+				}
+			}
+
+			//Committed private memory of the process: PrivateUsage on Windows, VmData of /proc/self/status elsewhere
+			double GetPrivateBytes()
+			{
+#ifdef _WIN32
+				PROCESS_MEMORY_COUNTERS_EX counters;
+				counters.cb = sizeof(counters);
+				if (!GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)))
+				{
+					return 0;
+				}
+
+				return static_cast<double>(counters.PrivateUsage);
+#else
+				ifstream status("/proc/self/status");
+				string line;
+				while (getline(status, line))
+				{
+					if (line.compare(0, 7, "VmData:") == 0)
+					{
+						return stod(line.substr(7)) * 1024;
+					}
+				}
+
+				return 0;
+#endif
+			}
+
+			//Countdown the fan-out calls signal and the caller waits on.
+			struct Countdown
+			{
+				explicit Countdown(const unsigned int& count)
+					: count_(count)
+				{}
+
+				//The last signal takes the lock: Wait reads the count under it, so the countdown cannot be destroyed before the notification is done
+				void Signal()
+				{
+					auto count = count_.load();
+					while (count > 1 && !count_.compare_exchange_weak(count, count - 1))
+					{
+					}
+
+					if (count == 1)
+					{
+						lock_guard<mutex> lock(mutex_);
+						count_--;
+						cdv_.notify_all();
+					}
+				}
+
+				void Wait()
+				{
+					unique_lock<mutex> lock(mutex_);
+					while (count_.load() != 0)
+					{
+						cdv_.wait(lock);
+					}
+				}
+
+				atomic<unsigned int> count_;
+				mutex mutex_;
+				condition_variable cdv_;
+			};
+
+			//Intake of the pool before the lock-free ring: a deque behind a mutex, idle consumers wait on a condition variable.
+			class MutexQueue
+			{
+			public:
+				MutexQueue()
+					: closed_(false)
+				{}
+
+				void Enqueue(const unsigned long long& value)
+				{
+					{
+						lock_guard<mutex> lock(mutex_);
+						queue_.push_back(value);
+					}
+					cdv_.notify_one();
+				}
+
+				//Wait for a value, return false once the queue is closed and empty
+				bool Dequeue(unsigned long long& value)
+				{
+					unique_lock<mutex> lock(mutex_);
+					while (queue_.empty() && !closed_)
+					{
+						cdv_.wait(lock);
+					}
+
+					if (queue_.empty())
+					{
+						return false;
+					}
+
+					value = queue_.front();
+					queue_.pop_front();
+					return true;
+				}
+
+				void Close()
+				{
+					{
+						lock_guard<mutex> lock(mutex_);
+						closed_ = true;
+					}
+					cdv_.notify_all();
+				}
+
+			private:
+				deque<unsigned long long> queue_;
+				bool closed_;
+				mutex mutex_;
+				condition_variable cdv_;
+			};
+
+			//Unit of work of the placement runs, large enough for the sweep to dominate the dispatch
+			const size_t PlacementChunkSize = 1024 * 1024;
+
+			//Capacity of the ring in the intake runs, the pool's default intake capacity
+			const size_t IntakeQueueCapacity = 1024;
+		}
+
+		Benchmark::Benchmark(const BenchmarkOptions& options)
+			:
+			options_(options)
+		{
+		}
+
+		vector<BenchmarkResult> Benchmark::RunThroughput() const
+		{
+			vector<BenchmarkResult> results;
+			for (auto useTasks : { true, false })
+			{
+				for (auto producerCount : options_.threadCounts_)
+				{
+					for (auto consumerCount : options_.threadCounts_)
+					{
+						ThreadPool pool(consumerCount, BenchmarkPoolName);
+						auto perProducer = max(1u, options_.throughputTaskCount_ / producerCount);
+						auto total = static_cast<unsigned long long>(perProducer) * producerCount;
+
+						vector<thread> producers;
+						auto start = chrono::steady_clock::now();
+						for (unsigned int i = 0; i < producerCount; i++)
+						{
+							producers.emplace_back([&pool, perProducer, useTasks]()
+							{
+								for (unsigned int j = 0; j < perProducer; j++)
+								{
+									if (useTasks)
+									{
+										pool.Enqueue(make_shared<Task>([]() {}));
+									}
+									else
+									{
+										pool.Post([]() {});
+									}
+								}
+							});
+						}
+
+						for (auto& producer : producers)
+						{
+							producer.join();
+						}
+
+						WaitForExecuted(pool, total);
+						auto elapsed = ElapsedNanoseconds(start, chrono::steady_clock::now());
+
+						BenchmarkResult result(useTasks ? "throughput.task" : "throughput.post");
+						result.Add("producers", producerCount);
+						result.Add("consumers", consumerCount);
+						result.Add("tasks", static_cast<double>(total));
+						result.Add("elapsedNs", elapsed);
+						result.Add("tasksPerSecond", total / elapsed * 1e9);
+						results.push_back(result);
+					}
+				}
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunIntakeQueue() const
+		{
+			vector<BenchmarkResult> results;
+			for (auto lockFree : { true, false })
+			{
+				for (auto producerCount : options_.threadCounts_)
+				{
+					for (auto consumerCount : options_.threadCounts_)
+					{
+						auto perProducer = max(1u, options_.throughputTaskCount_ / producerCount);
+						auto total = static_cast<unsigned long long>(perProducer) * producerCount;
+						BoundedQueue<unsigned long long> ring(IntakeQueueCapacity);
+						MutexQueue locked;
+						atomic<bool> produced(false);
+						atomic<unsigned long long> consumed(0);
+
+						//The ring's producers and consumers retry with a yield where the pool would park them, so that the queues themselves are compared
+						vector<thread> producers;
+						vector<thread> consumers;
+						auto start = chrono::steady_clock::now();
+						for (unsigned int i = 0; i < consumerCount; i++)
+						{
+							consumers.emplace_back([&ring, &locked, &produced, &consumed, lockFree]()
+							{
+								unsigned long long value;
+								unsigned long long count = 0;
+								if (lockFree)
+								{
+									for (;;)
+									{
+										if (ring.TryDequeue(value))
+										{
+											count++;
+										}
+										else if (produced.load() && ring.IsEmpty())
+										{
+											break;
+										}
+										else
+										{
+											this_thread::yield();
+										}
+									}
+								}
+								else
+								{
+									while (locked.Dequeue(value))
+									{
+										count++;
+									}
+								}
+
+								consumed += count;
+							});
+						}
+
+						for (unsigned int i = 0; i < producerCount; i++)
+						{
+							producers.emplace_back([&ring, &locked, perProducer, lockFree]()
+							{
+								for (unsigned long long j = 0; j < perProducer; j++)
+								{
+									if (!lockFree)
+									{
+										locked.Enqueue(j);
+										continue;
+									}
+
+									while (!ring.TryEnqueue(j))
+									{
+										this_thread::yield();
+									}
+								}
+							});
+						}
+
+						for (auto& producer : producers)
+						{
+							producer.join();
+						}
+
+						produced = true;
+						locked.Close();
+						for (auto& consumer : consumers)
+						{
+							consumer.join();
+						}
+						auto elapsed = ElapsedNanoseconds(start, chrono::steady_clock::now());
+
+						BenchmarkResult result(lockFree ? "intakeQueue.ring" : "intakeQueue.mutex");
+						result.Add("producers", producerCount);
+						result.Add("consumers", consumerCount);
+						result.Add("values", static_cast<double>(total));
+						result.Add("consumed", static_cast<double>(consumed.load()));
+						result.Add("elapsedNs", elapsed);
+						result.Add("valuesPerSecond", total / elapsed * 1e9);
+						results.push_back(result);
+					}
+				}
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunSubmitLatency() const
+		{
+			vector<BenchmarkResult> results;
+			ThreadPool pool(thread::hardware_concurrency(), BenchmarkPoolName);
+			vector<double> samples(options_.latencyTaskCount_);
+			for (auto call : IntakeCalls)
+			{
+				//Idle: the next task is only submitted once the previous one started, so every task wakes a worker
+				{
+					atomic<unsigned int> started(0);
+					for (unsigned int i = 0; i < options_.latencyTaskCount_; i++)
+					{
+						auto submitTime = chrono::steady_clock::now();
+						CallPool(pool, call, [&samples, &started, i, submitTime]()
+						{
+							samples[i] = ElapsedNanoseconds(submitTime, chrono::steady_clock::now());
+							started++;
+						});
+
+						while (started.load() <= i)
+						{
+							this_thread::yield();
+						}
+					}
+
+					BenchmarkResult result("submitLatency.idle." + GetIntakeCallName(call));
+					result.Add("consumers", pool.GetPoolSize());
+					AddDistribution(result, samples);
+					results.push_back(result);
+				}
+
+				//Burst: all submitted back to back, the later ones also wait behind the earlier ones
+				{
+					Countdown countdown(options_.latencyTaskCount_);
+					for (unsigned int i = 0; i < options_.latencyTaskCount_; i++)
+					{
+						auto submitTime = chrono::steady_clock::now();
+						CallPool(pool, call, [&samples, &countdown, i, submitTime]()
+						{
+							samples[i] = ElapsedNanoseconds(submitTime, chrono::steady_clock::now());
+							countdown.Signal();
+						});
+					}
+					countdown.Wait();
+
+					BenchmarkResult result("submitLatency.burst." + GetIntakeCallName(call));
+					result.Add("consumers", pool.GetPoolSize());
+					AddDistribution(result, samples);
+					results.push_back(result);
+				}
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunFanOut() const
+		{
+			vector<BenchmarkResult> results;
+			auto pPool = make_shared<ThreadPool>(thread::hardware_concurrency(), BenchmarkPoolName);
+			auto width = max(1u, options_.fanOutWidth_);
+
+			vector<double> samples;
+			for (unsigned int round = 0; round < options_.fanOutRounds_; round++)
+			{
+				TaskGraph graph(pPool);
+				auto root = graph.Add([]() {});
+				vector<TaskGraph::NodeId> leaves;
+				for (unsigned int i = 0; i < width; i++)
+				{
+					auto leaf = graph.Add([]() {});
+					graph.AddDependency(root, leaf);
+					leaves.push_back(leaf);
+				}
+				graph.WhenAll(leaves);
+
+				auto start = chrono::steady_clock::now();
+				graph.Run();
+				graph.Wait();
+				samples.push_back(ElapsedNanoseconds(start, chrono::steady_clock::now()));
+			}
+
+			BenchmarkResult graphResult("fanOut.taskGraph");
+			graphResult.Add("width", width);
+			graphResult.Add("consumers", pPool->GetPoolSize());
+			AddEdgeDistribution(graphResult, samples, 2 * width);
+			results.push_back(graphResult);
+
+			samples.clear();
+			for (unsigned int round = 0; round < options_.fanOutRounds_; round++)
+			{
+				Countdown countdown(width);
+				auto start = chrono::steady_clock::now();
+				pPool->Post([pPool, &countdown, width]()
+				{
+					for (unsigned int i = 0; i < width; i++)
+					{
+						pPool->Post([&countdown]() { countdown.Signal(); });
+					}
+				});
+				countdown.Wait();
+				samples.push_back(ElapsedNanoseconds(start, chrono::steady_clock::now()));
+			}
+
+			BenchmarkResult postResult("fanOut.post");
+			postResult.Add("width", width);
+			postResult.Add("consumers", pPool->GetPoolSize());
+			AddEdgeDistribution(postResult, samples, width);
+			results.push_back(postResult);
+
+			//Deep chain: every task released by the previous one, nothing runs in parallel
+			auto length = max(1u, options_.chainLength_);
+			samples.clear();
+			for (unsigned int round = 0; round < options_.fanOutRounds_; round++)
+			{
+				TaskGraph graph(pPool);
+				auto previous = graph.Add([]() {});
+				for (unsigned int i = 1; i < length; i++)
+				{
+					auto next = graph.Add([]() {});
+					graph.AddDependency(previous, next);
+					previous = next;
+				}
+
+				auto start = chrono::steady_clock::now();
+				graph.Run();
+				graph.Wait();
+				samples.push_back(ElapsedNanoseconds(start, chrono::steady_clock::now()));
+			}
+
+			BenchmarkResult chainGraphResult("chain.taskGraph");
+			chainGraphResult.Add("length", length);
+			chainGraphResult.Add("consumers", pPool->GetPoolSize());
+			AddEdgeDistribution(chainGraphResult, samples, length - 1);
+			results.push_back(chainGraphResult);
+
+			samples.clear();
+			for (unsigned int round = 0; round < options_.fanOutRounds_; round++)
+			{
+				Countdown countdown(1);
+				function<void(unsigned int)> step = [pPool, &countdown, &step](unsigned int remaining)
+				{
+					if (remaining == 0)
+					{
+						countdown.Signal();
+						return;
+					}
+
+					pPool->Post([&step, remaining]() { step(remaining - 1); });
+				};
+
+				auto start = chrono::steady_clock::now();
+				pPool->Post([&step, length]() { step(length - 1); });
+				countdown.Wait();
+				samples.push_back(ElapsedNanoseconds(start, chrono::steady_clock::now()));
+			}
+
+			BenchmarkResult chainPostResult("chain.post");
+			chainPostResult.Add("length", length);
+			chainPostResult.Add("consumers", pPool->GetPoolSize());
+			AddEdgeDistribution(chainPostResult, samples, length - 1);
+			results.push_back(chainPostResult);
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunTimerAccuracy() const
+		{
+			struct Fires
+			{
+				mutex mutex_;
+				condition_variable cdv_;
+				vector<chrono::steady_clock::time_point> times_;
+			};
+
+			vector<BenchmarkResult> results;
+			auto fireCount = max(2u, options_.timerFireCount_);
+			for (auto interval : { options_.timerInterval_, options_.timerPreciseInterval_ })
+			{
+				for (auto precision : { CoarseTimerPrecision, HighTimerPrecision })
+				{
+					auto pFires = make_shared<Fires>();
+					CancellationSource source;
+					auto firstTime = chrono::steady_clock::now() + interval;
+					{
+						auto pPool = make_shared<ThreadPool>(thread::hardware_concurrency(), BenchmarkPoolName);
+						Scheduler scheduler(pPool, min(interval, chrono::system_clock::duration(chrono::milliseconds(1))), 1000000, chrono::milliseconds(1000), TimerHeapQueue, chrono::milliseconds(1), 1, precision);
+
+						auto pTask = make_shared<Task>([pFires]()
+						{
+							auto now = chrono::steady_clock::now();
+							lock_guard<mutex> lock(pFires->mutex_);
+							pFires->times_.push_back(now);
+							pFires->cdv_.notify_all();
+						}, "BenchmarkTimer");
+						pTask->SetCancellationToken(source.GetToken());
+						scheduler.RunRecurringTaskAt(chrono::system_clock::now() + chrono::duration_cast<chrono::system_clock::duration>(firstTime - chrono::steady_clock::now()), interval, pTask);
+
+						//Give up waiting after twice the expected time, the missed occurrences are reported
+						unique_lock<mutex> lock(pFires->mutex_);
+						pFires->cdv_.wait_until(lock, firstTime + interval * (2 * fireCount), [&pFires, fireCount]() { return pFires->times_.size() >= fireCount; });
+						source.Cancel();
+					}
+
+					vector<chrono::steady_clock::time_point> times;
+					{
+						lock_guard<mutex> lock(pFires->mutex_);
+						times = pFires->times_;
+					}
+
+					//Lateness behind the slot of the interval grid the occurrence falls in, and error of the gaps between occurrences
+					vector<double> lateness;
+					vector<double> gapErrors;
+					auto intervalNs = chrono::duration<double, nano>(interval).count();
+					for (size_t i = 0; i < times.size(); i++)
+					{
+						auto sinceFirst = chrono::duration<double, nano>(times[i] - firstTime).count();
+						lateness.push_back(max(0.0, fmod(sinceFirst, intervalNs)));
+						if (i > 0)
+						{
+							gapErrors.push_back(fabs(chrono::duration<double, nano>(times[i] - times[i - 1]).count() - intervalNs));
+						}
+					}
+
+					double slotCount = 0;
+					if (!times.empty())
+					{
+						slotCount = floor(chrono::duration<double, nano>(times.back() - firstTime).count() / intervalNs) + 1;
+					}
+
+					string suffix = precision == HighTimerPrecision ? ".high" : ".coarse";
+					BenchmarkResult latenessResult("timerLateness" + suffix);
+					latenessResult.Add("intervalNs", intervalNs);
+					latenessResult.Add("fires", static_cast<double>(times.size()));
+					latenessResult.Add("missedSlots", max(0.0, slotCount - times.size()));
+					AddDistribution(latenessResult, lateness);
+					results.push_back(latenessResult);
+
+					BenchmarkResult gapResult("timerIntervalError" + suffix);
+					gapResult.Add("intervalNs", intervalNs);
+					AddDistribution(gapResult, gapErrors);
+					results.push_back(gapResult);
+				}
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunMemory() const
+		{
+			vector<BenchmarkResult> results;
+			auto taskCount = max(1u, options_.memoryTaskCount_);
+			for (auto call : IntakeCalls)
+			{
+				//A single worker held by a gate, everything enqueued after it stays queued.
+				//The intake slots are allocated with the pool, the growth only counts what each task allocates beyond its slot.
+				ThreadPool pool(1, BenchmarkPoolName, 10000, taskCount + 1, THREAD_PRIORITY_NORMAL, SharedQueue, taskCount + 1);
+				promise<void> gate;
+				auto gateFuture = gate.get_future().share();
+				pool.Post([gateFuture]() { gateFuture.wait(); });
+
+				auto before = GetPrivateBytes();
+				for (unsigned int i = 0; i < taskCount; i++)
+				{
+					CallPool(pool, call, []() {});
+				}
+				auto after = GetPrivateBytes();
+
+				gate.set_value();
+				WaitForExecuted(pool, taskCount + 1);
+
+				BenchmarkResult result("memory." + GetIntakeCallName(call));
+				result.Add("queued", taskCount);
+				result.Add("sizeofTask", sizeof(Task));
+				result.Add("sizeofWorkItem", sizeof(WorkItem));
+				result.Add("bytesPerQueued", (after - before) / taskCount);
+				results.push_back(result);
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunParallelScaling() const
+		{
+			vector<BenchmarkResult> results;
+			auto count = max(1u, options_.parallelElementCount_);
+			vector<unsigned long long> input(count);
+			{
+				mt19937_64 random(count);
+				for (auto& value : input)
+				{
+					value = random();
+				}
+			}
+
+			const char* names[] = { "parallelScaling.for", "parallelScaling.reduce", "parallelScaling.sort" };
+			double oneWorkerMeans[] = { 0, 0, 0 };
+			vector<unsigned long long> data;
+			unsigned long long sum = 0;
+			for (unsigned int poolSize = 1; poolSize <= max(1u, thread::hardware_concurrency()); poolSize++)
+			{
+				ThreadPool pool(poolSize, BenchmarkPoolName);
+				for (unsigned int algorithm = 0; algorithm < 3; algorithm++)
+				{
+					vector<double> samples;
+					for (unsigned int round = 0; round < options_.parallelRounds_; round++)
+					{
+						data = input;
+						auto start = chrono::steady_clock::now();
+						switch (algorithm)
+						{
+						case 0:
+							ParallelFor(pool, size_t(0), data.size(), [&data](size_t i) { data[i] = data[i] * 6364136223846793005ull + 1442695040888963407ull; });
+							break;
+						case 1:
+							sum = ParallelReduce(pool, size_t(0), data.size(), 0ull, [&data](size_t i) { return data[i] >> 8; }, [](unsigned long long left, unsigned long long right) { return left + right; });
+							break;
+						default:
+							ParallelSort(pool, data.begin(), data.end());
+							break;
+						}
+						samples.push_back(ElapsedNanoseconds(start, chrono::steady_clock::now()));
+					}
+
+					auto mean = samples.empty() ? 0 : accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+					if (poolSize == 1)
+					{
+						oneWorkerMeans[algorithm] = mean;
+					}
+
+					BenchmarkResult result(names[algorithm]);
+					result.Add("poolSize", poolSize);
+					result.Add("elements", count);
+					if (mean > 0)
+					{
+						result.Add("elementsPerSecond", count / mean * 1e9);
+						result.Add("speedup", oneWorkerMeans[algorithm] / mean);
+					}
+					//The sum, or the middle element of the data, written out so that the work cannot be optimized away
+					result.Add("output", static_cast<double>(algorithm == 1 ? sum : data[data.size() / 2]));
+					AddDistribution(result, samples);
+					results.push_back(result);
+				}
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunPlacement() const
+		{
+			vector<BenchmarkResult> results;
+			auto valueCount = PlacementChunkSize / sizeof(unsigned long long);
+			auto chunkCount = max<size_t>(1, options_.placementBufferSize_ / PlacementChunkSize);
+			for (auto policy : { NoPlacement, Compact, Scatter, PerNode })
+			{
+				ThreadPool pool(thread::hardware_concurrency(), BenchmarkPoolName, 10000, 1000000, THREAD_PRIORITY_NORMAL, SharedQueue, 1024, ElasticPolicy(), WorkerPlacement(policy));
+				auto nodes = pool.GetNodes();
+
+				//Chunk i belongs to node i % nodes: it is written first by a task queued to that node, so that its pages are allocated there, then summed by the same node
+				vector<unique_ptr<unsigned long long[]>> chunks(chunkCount);
+				vector<unsigned long long> sums(chunkCount, 0);
+				auto runPass = [&pool, &nodes, chunkCount](const function<void(size_t)>& sweep)
+				{
+					Countdown countdown(static_cast<unsigned int>(chunkCount));
+					for (size_t i = 0; i < chunkCount; i++)
+					{
+						pool.Enqueue(make_shared<Task>([&sweep, &countdown, i]()
+						{
+							sweep(i);
+							countdown.Signal();
+						}), static_cast<int>(nodes[i % nodes.size()]));
+					}
+					countdown.Wait();
+				};
+
+				for (auto& chunk : chunks)
+				{
+					chunk.reset(new unsigned long long[valueCount]);
+				}
+				runPass([&chunks, valueCount](size_t i)
+				{
+					auto pChunk = chunks[i].get();
+					for (size_t j = 0; j < valueCount; j++)
+					{
+						pChunk[j] = j;
+					}
+				});
+
+				auto start = chrono::steady_clock::now();
+				for (unsigned int pass = 0; pass < options_.placementPasses_; pass++)
+				{
+					runPass([&chunks, &sums, valueCount](size_t i)
+					{
+						auto pChunk = chunks[i].get();
+						unsigned long long sum = 0;
+						for (size_t j = 0; j < valueCount; j++)
+						{
+							sum += pChunk[j];
+						}
+						sums[i] += sum;
+					});
+				}
+				auto elapsed = ElapsedNanoseconds(start, chrono::steady_clock::now());
+
+				//Policy names as in PlacementPolicy, the policy in effect and the unpinned workers tell whether the pinning took place
+				const char* names[] = { "placement.none", "placement.compact", "placement.scatter", "placement.perNode" };
+				BenchmarkResult result(names[policy]);
+				result.Add("policyInEffect", pool.GetPlacementPolicy());
+				result.Add("nodes", static_cast<double>(nodes.size()));
+				result.Add("consumers", pool.GetPoolSize());
+				result.Add("unpinnedWorkers", static_cast<double>(pool.GetUnpinnedWorkerCount()));
+				result.Add("bytes", static_cast<double>(chunkCount * PlacementChunkSize) * options_.placementPasses_);
+				result.Add("elapsedNs", elapsed);
+				result.Add("bytesPerSecond", chunkCount * PlacementChunkSize * static_cast<double>(options_.placementPasses_) / elapsed * 1e9);
+				result.Add("checksum", static_cast<double>(accumulate(sums.begin(), sums.end(), 0ull)));
+				results.push_back(result);
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunTimerQueue() const
+		{
+			vector<BenchmarkResult> results;
+			//One task shared by all the timers, so that the bytes measured are the queue's own
+			auto pTask = make_shared<Task>([]() {});
+			const unsigned int FireSteps = 1000;
+			for (auto timerCount : options_.timerQueueSizes_)
+			{
+				for (auto kind : { TimerHeapQueue, TimingWheelQueue })
+				{
+					vector<chrono::steady_clock::time_point> startTimes;
+					auto origin = chrono::steady_clock::now();
+					{
+						mt19937 random(timerCount);
+						uniform_int_distribution<chrono::steady_clock::rep> offset(0, chrono::duration_cast<chrono::steady_clock::duration>(options_.timerQueueHorizon_).count());
+						startTimes.reserve(timerCount);
+						for (unsigned int i = 0; i < timerCount; i++)
+						{
+							startTimes.push_back(origin + chrono::steady_clock::duration(offset(random)));
+						}
+					}
+
+					auto before = GetPrivateBytes();
+					shared_ptr<TimerQueue> pQueue;
+					if (kind == TimingWheelQueue)
+					{
+						pQueue = make_shared<TimingWheel>();
+					}
+					else
+					{
+						pQueue = make_shared<TimerHeap>();
+					}
+
+					auto start = chrono::steady_clock::now();
+					for (auto& startTime : startTimes)
+					{
+						pQueue->Push(TimeAndIntervalAndTask(pTask, chrono::seconds(0), startTime));
+					}
+					auto pushed = chrono::steady_clock::now();
+					auto after = GetPrivateBytes();
+
+					//Fire everything in FireSteps calls to PopDue with a clock moving over the horizon, and one more step for the wheel's last tick
+					vector<TimeAndIntervalAndTask> due;
+					size_t fired = 0;
+					auto fireStart = chrono::steady_clock::now();
+					for (unsigned int step = 1; pQueue->GetSize() > 0; step++)
+					{
+						due.clear();
+						pQueue->PopDue(origin + options_.timerQueueHorizon_ * step / FireSteps, due);
+						fired += due.size();
+						for (auto& timer : due)
+						{
+							pQueue->Release(timer.timerId_);
+						}
+					}
+					auto end = chrono::steady_clock::now();
+
+					BenchmarkResult result(kind == TimingWheelQueue ? "timerQueue.wheel" : "timerQueue.heap");
+					result.Add("timers", timerCount);
+					result.Add("pushNsPerTimer", ElapsedNanoseconds(start, pushed) / timerCount);
+					result.Add("fireNsPerTimer", ElapsedNanoseconds(fireStart, end) / timerCount);
+					result.Add("fired", static_cast<double>(fired));
+					result.Add("bytesPerTimer", (after - before) / timerCount);
+					results.push_back(result);
+				}
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunSchedulerInsert() const
+		{
+			vector<BenchmarkResult> results;
+			auto pTask = make_shared<Task>([]() {});
+			for (auto producerCount : options_.threadCounts_)
+			{
+				vector<unsigned int> shardCounts(1, 1);
+				if (producerCount > 1)
+				{
+					shardCounts.push_back(producerCount);
+				}
+
+				for (auto shardCount : shardCounts)
+				{
+					auto pPool = make_shared<ThreadPool>(1, BenchmarkPoolName);
+					Scheduler scheduler(pPool, chrono::milliseconds(100), options_.schedulerInsertCount_ + producerCount, chrono::milliseconds(1000), TimingWheelQueue, chrono::milliseconds(1), shardCount);
+					auto perProducer = max(1u, options_.schedulerInsertCount_ / producerCount);
+					auto startTime = chrono::system_clock::now() + chrono::hours(1);
+
+					vector<thread> producers;
+					auto start = chrono::steady_clock::now();
+					for (unsigned int i = 0; i < producerCount; i++)
+					{
+						producers.emplace_back([&scheduler, &pTask, perProducer, startTime, i]()
+						{
+							for (unsigned int j = 0; j < perProducer; j++)
+							{
+								scheduler.RunTaskAt(startTime + chrono::microseconds(j), pTask, i);
+							}
+						});
+					}
+
+					for (auto& producer : producers)
+					{
+						producer.join();
+					}
+					auto end = chrono::steady_clock::now();
+
+					BenchmarkResult result("schedulerInsert");
+					result.Add("producers", producerCount);
+					result.Add("shards", shardCount);
+					result.Add("inserted", static_cast<double>(scheduler.GetPendingTaskCount()));
+					result.Add("insertsPerSecond", perProducer * producerCount / (ElapsedNanoseconds(start, end) / 1e9));
+					results.push_back(result);
+				}
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunTimerBurst() const
+		{
+			vector<BenchmarkResult> results;
+			for (auto kind : { TimerHeapQueue, TimingWheelQueue })
+			{
+				auto pPool = make_shared<ThreadPool>(thread::hardware_concurrency(), BenchmarkPoolName);
+				Scheduler scheduler(pPool, chrono::milliseconds(100), options_.timerBurstCount_ + 1, chrono::milliseconds(1000), kind);
+
+				vector<shared_ptr<Task>> tasks;
+				tasks.reserve(options_.timerBurstCount_);
+				for (unsigned int i = 0; i < options_.timerBurstCount_; i++)
+				{
+					tasks.push_back(make_shared<Task>([]() {}, "BenchmarkBurst"));
+				}
+
+				//Leave time to arm all the tasks before they are due, arming longer than that shows in the result
+				auto dueTime = chrono::system_clock::now() + chrono::seconds(1);
+				auto armStart = chrono::steady_clock::now();
+				for (auto& pTask : tasks)
+				{
+					scheduler.RunTaskAt(dueTime, pTask);
+				}
+				auto armEnd = chrono::steady_clock::now();
+
+				//Stop waiting after ten seconds, the tasks that did not start are reported
+				auto giveUpTime = dueTime + chrono::seconds(10);
+				while (pPool->GetExecutedTaskCount() < options_.timerBurstCount_ && chrono::system_clock::now() < giveUpTime)
+				{
+					this_thread::sleep_for(chrono::milliseconds(1));
+				}
+
+				vector<double> latencies;
+				for (auto& pTask : tasks)
+				{
+					if (pTask->GetState() == Complete)
+					{
+						latencies.push_back(max(0.0, chrono::duration<double, nano>(pTask->GetStartTime() - dueTime).count()));
+					}
+				}
+
+				BenchmarkResult result(kind == TimingWheelQueue ? "timerBurst.wheel" : "timerBurst.heap");
+				result.Add("timers", options_.timerBurstCount_);
+				result.Add("armingNs", ElapsedNanoseconds(armStart, armEnd));
+				AddDistribution(result, latencies);
+				results.push_back(result);
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunTimerCoalescing() const
+		{
+			struct Fires
+			{
+				mutex mutex_;
+				vector<double> lateness_;
+			};
+
+			vector<BenchmarkResult> results;
+			auto interval = options_.timerCoalescingInterval_;
+			auto intervalNs = chrono::duration<double, nano>(interval).count();
+			for (auto slack : options_.timerCoalescingSlacks_)
+			{
+				auto pFires = make_shared<Fires>();
+				unsigned long long wakeups = 0;
+				{
+					auto pPool = make_shared<ThreadPool>(thread::hardware_concurrency(), BenchmarkPoolName);
+					Scheduler scheduler(pPool, min(interval, chrono::system_clock::duration(chrono::milliseconds(100))));
+
+					//Arming wakes the enqueue thread, only the wakeups from the first slot on are counted
+					auto firstSlot = chrono::steady_clock::now() + chrono::milliseconds(100);
+					auto systemFirstSlot = chrono::system_clock::now() + chrono::milliseconds(100);
+					mt19937 random(options_.timerCoalescingCount_);
+					uniform_int_distribution<chrono::system_clock::rep> phase(0, interval.count() - 1);
+					for (unsigned int i = 0; i < options_.timerCoalescingCount_; i++)
+					{
+						auto offset = chrono::system_clock::duration(phase(random));
+						auto firstTime = firstSlot + chrono::duration_cast<chrono::steady_clock::duration>(offset);
+						scheduler.RunRecurringTaskAt(systemFirstSlot + offset, interval, make_shared<Task>([pFires, firstTime, intervalNs]()
+						{
+							auto sinceFirst = chrono::duration<double, nano>(chrono::steady_clock::now() - firstTime).count();
+							lock_guard<mutex> lock(pFires->mutex_);
+							pFires->lateness_.push_back(max(0.0, fmod(sinceFirst, intervalNs)));
+						}, "BenchmarkCoalescing"), AnyShard, slack);
+					}
+
+					this_thread::sleep_until(firstSlot);
+					auto before = scheduler.GetWakeupCount();
+					this_thread::sleep_for(options_.timerCoalescingDuration_);
+					wakeups = scheduler.GetWakeupCount() - before;
+				}
+
+				vector<double> lateness;
+				{
+					lock_guard<mutex> lock(pFires->mutex_);
+					lateness = pFires->lateness_;
+				}
+
+				BenchmarkResult result("timerCoalescing");
+				result.Add("timers", options_.timerCoalescingCount_);
+				result.Add("intervalNs", intervalNs);
+				result.Add("slackNs", chrono::duration<double, nano>(slack).count());
+				result.Add("fires", static_cast<double>(lateness.size()));
+				result.Add("wakeups", static_cast<double>(wakeups));
+				result.Add("wakeupsPerSecond", wakeups / chrono::duration<double>(options_.timerCoalescingDuration_).count());
+				AddDistribution(result, lateness);
+				results.push_back(result);
+			}
+
+			return results;
+		}
+
+		vector<BenchmarkResult> Benchmark::RunAll() const
+		{
+			vector<BenchmarkResult> results;
+			for (auto run : { &Benchmark::RunThroughput, &Benchmark::RunIntakeQueue, &Benchmark::RunSubmitLatency, &Benchmark::RunFanOut, &Benchmark::RunParallelScaling, &Benchmark::RunTimerAccuracy, &Benchmark::RunMemory, &Benchmark::RunPlacement, &Benchmark::RunTimerQueue, &Benchmark::RunSchedulerInsert, &Benchmark::RunTimerBurst, &Benchmark::RunTimerCoalescing })
+			{
+				auto runResults = (this->*run)();
+				results.insert(results.end(), runResults.begin(), runResults.end());
+			}
+
+			return results;
+		}
+
+		void Benchmark::Run(ostream& output) const
+		{
+			WriteJson(RunAll(), output);
+		}
+
+		void Benchmark::WriteJson(const vector<BenchmarkResult>& results, ostream& output)
+		{
+			//Names and keys are plain identifiers, nothing needs escaping
+			auto precision = output.precision(15);
+			output << "{\n  \"hardwareConcurrency\": " << thread::hardware_concurrency() << ",\n  \"results\": [";
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				output << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << results[i].name_ << "\"";
+				for (auto& value : results[i].values_)
+				{
+					output << ", \"" << value.first << "\": ";
+					if (isfinite(value.second))
+					{
+						output << value.second;
+					}
+					else
+					{
+						output << "null";
+					}
+				}
+				output << " }";
+			}
+			output << "\n  ]\n}\n";
+			output.precision(precision);
+		}
+	}
+}
\ No newline at end of file
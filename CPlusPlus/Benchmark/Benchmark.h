@@ -0,0 +1,132 @@
+#pragma once
+#include "Task.h"
+#include "ThreadPool.h"
+#include "Scheduler.h"
+
+namespace utils
+{
+	namespace thread_management
+	{
+		//Sizes of the benchmark runs, the defaults take a few tens of seconds on a desktop.
+		struct BenchmarkOptions
+		{
+			BenchmarkOptions()
+				: threadCounts_({ 1, 2, 4, 8, 16, 32, 64 }),
+				throughputTaskCount_(100000),
+				latencyTaskCount_(10000),
+				fanOutWidth_(1000),
+				fanOutRounds_(50),
+				chainLength_(1000),
+				timerInterval_(std::chrono::milliseconds(10)),
+				timerFireCount_(200),
+				timerPreciseInterval_(std::chrono::microseconds(500)),
+				memoryTaskCount_(100000),
+				placementBufferSize_(256 * 1024 * 1024),
+				placementPasses_(10),
+				parallelElementCount_(10000000),
+				parallelRounds_(5),
+				timerQueueSizes_({ 10000, 1000000, 10000000 }),
+				timerQueueHorizon_(std::chrono::minutes(10)),
+				schedulerInsertCount_(1000000),
+				timerBurstCount_(100000),
+				timerCoalescingCount_(1000),
+				timerCoalescingInterval_(std::chrono::seconds(1)),
+				timerCoalescingSlacks_({ std::chrono::milliseconds(0), std::chrono::milliseconds(10), std::chrono::milliseconds(100) }),
+				timerCoalescingDuration_(std::chrono::seconds(5))
+			{}
+
+			//Producer and consumer counts of the throughput runs, every pair is measured
+			std::vector<unsigned int> threadCounts_;
+			unsigned int throughputTaskCount_;
+			unsigned int latencyTaskCount_;
+			unsigned int fanOutWidth_;
+			unsigned int fanOutRounds_;
+			//Tasks of the chain runs, each one depending on the previous, measured fanOutRounds_ times
+			unsigned int chainLength_;
+			std::chrono::system_clock::duration timerInterval_;
+			unsigned int timerFireCount_;
+			//Sub-millisecond interval of the timer runs, next to timerInterval_
+			std::chrono::system_clock::duration timerPreciseInterval_;
+			unsigned int memoryTaskCount_;
+			//Bytes swept by the placement runs, well beyond the caches, and sweeps over all of them
+			size_t placementBufferSize_;
+			unsigned int placementPasses_;
+			//Elements of the parallel algorithm runs, each measured parallelRounds_ times on every pool size
+			unsigned int parallelElementCount_;
+			unsigned int parallelRounds_;
+			//Timers held at once by the TimerQueue runs, spread evenly over the horizon
+			std::vector<unsigned int> timerQueueSizes_;
+			std::chrono::system_clock::duration timerQueueHorizon_;
+			//Tasks armed by all the producers of a Scheduler insert run
+			unsigned int schedulerInsertCount_;
+			//One-shot Scheduler tasks all due at the same time
+			unsigned int timerBurstCount_;
+			//Recurring Scheduler tasks of the same interval at random phases, measured for each slack over the duration
+			unsigned int timerCoalescingCount_;
+			std::chrono::system_clock::duration timerCoalescingInterval_;
+			std::vector<std::chrono::system_clock::duration> timerCoalescingSlacks_;
+			std::chrono::system_clock::duration timerCoalescingDuration_;
+		};
+
+		//One run of a benchmark: its parameters and measures, durations in nanoseconds.
+		struct BenchmarkResult
+		{
+			explicit BenchmarkResult(const std::string& name)
+				: name_(name)
+			{}
+
+			void Add(const std::string& key, const double& value)
+			{
+				values_.push_back(std::make_pair(key, value));
+			}
+
+			std::string name_;
+			//Written in this order
+			std::vector<std::pair<std::string, double>> values_;
+		};
+
+		//Microbenchmarks of ThreadPool, Scheduler and Task, reported as JSON so that runs can be compared over time.
+		//Results are named group.variant in camelCase, such as throughput.task or timerLateness.coarse, and so are their values.
+		//main.cpp runs them all from the Benchmark console project, which links Utils and, on Windows, psapi.
+		class Benchmark
+		{
+		public:
+			explicit Benchmark(const BenchmarkOptions& options = BenchmarkOptions());
+
+			//Empty tasks and posted calls per second, for every pair of producer and consumer counts.
+			std::vector<BenchmarkResult> RunThroughput() const;
+			//Values passed per second through the pool's lock-free intake ring and through a deque behind a mutex, the intake it replaced, for every pair of producer and consumer counts.
+			std::vector<BenchmarkResult> RunIntakeQueue() const;
+			//Time from submission to the start of the task through Enqueue, Post and Submit, one at a time on an idle pool and in a burst.
+			std::vector<BenchmarkResult> RunSubmitLatency() const;
+			//One task fanning out to fanOutWidth_ tasks joined by one, and a chain of chainLength_ tasks, through a TaskGraph and through posted calls, with the cost per edge.
+			std::vector<BenchmarkResult> RunFanOut() const;
+			//Lateness of the occurrences of a recurring Scheduler task behind their slot, at timerInterval_ and timerPreciseInterval_ with each TimerPrecision.
+			std::vector<BenchmarkResult> RunTimerAccuracy() const;
+			//Growth of the private bytes of the process per task queued through Enqueue, Post and Submit.
+			std::vector<BenchmarkResult> RunMemory() const;
+			//ParallelFor, ParallelReduce and ParallelSort over parallelElementCount_ elements on pools of 1 to hardware_concurrency workers, with the speedup over one worker.
+			//The calling thread helps in every run, so a pool of n workers runs on n + 1 threads.
+			std::vector<BenchmarkResult> RunParallelScaling() const;
+			//Bytes per second summed by a pool of hardware_concurrency workers over a buffer each node's workers wrote first, with each PlacementPolicy.
+			std::vector<BenchmarkResult> RunPlacement() const;
+			//Push and fire cost and bytes per timer of the Scheduler's TimerHeap and TimingWheel, without the pool and the enqueue thread.
+			std::vector<BenchmarkResult> RunTimerQueue() const;
+			//Tasks armed per second by concurrent producers, for every thread count, on one shard and on one shard per producer.
+			std::vector<BenchmarkResult> RunSchedulerInsert() const;
+			//Time from the due time to the start of the task, for timerBurstCount_ tasks due at once.
+			std::vector<BenchmarkResult> RunTimerBurst() const;
+			//Wakeups of the enqueue thread per second and lateness of the occurrences behind their slot, for timerCoalescingCount_ recurring tasks with each slack.
+			std::vector<BenchmarkResult> RunTimerCoalescing() const;
+
+			std::vector<BenchmarkResult> RunAll() const;
+			//Run everything and write one JSON document.
+			void Run(std::ostream& output) const;
+
+			static void WriteJson(const std::vector<BenchmarkResult>& results, std::ostream& output);
+
+		private:
+			BenchmarkOptions options_;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "stdafx.h"
+#include "Benchmark.h"
+
+using namespace std;
+using namespace utils::thread_management;
+
+//Run every benchmark with the default options and write the JSON document to the file named by the first argument, or to the standard output.
+//The benchmarks themselves only reach Win32 for the memory counters and fall back to /proc elsewhere, so they build wherever Utils does; Utils still needs <windows.h>.
+int main(int argc, char* argv[])
+{
+	Benchmark benchmark;
+	if (argc < 2)
+	{
+		benchmark.Run(cout);
+		return 0;
+	}
+
+	ofstream file(argv[1]);
+	if (!file)
+	{
+		cerr << "Fail to open " << argv[1] << endl;
+		return 1;
+	}
+
+	benchmark.Run(file);
+	return file ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#include <windows.h>
+#ifdef _WIN32
+#include <psapi.h>
+#endif
+
+//Everything the Utils headers expect from their own stdafx.h, plus what the benchmarks use on top of it
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <locale>
+#include <codecvt>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <memory>
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <queue>
+#include <future>
+#include <unordered_map>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <intrin.h>
@@ -0,0 +1,189 @@
+#pragma once
+
+namespace utils
+{
+	namespace thread_management
+	{
+		//Bounded lock-free multi-producer/multi-consumer ring buffer.
+		//Every cell carries a sequence number telling producers and consumers whose turn it is, so a push or a pop is one CAS on the shared position plus one release store on the cell.
+		//The capacity is rounded up to a power of two.
+		template <typename T>
+		class BoundedQueue
+		{
+		public:
+			explicit BoundedQueue(size_t capacity)
+				: enqueuePos_(0),
+				dequeuePos_(0)
+			{
+				size_t size = 2;
+				while (size < capacity)
+				{
+					size <<= 1;
+				}
+
+				mask_ = size - 1;
+				cells_.reset(new Cell[size]);
+				for (size_t i = 0; i < size; i++)
+				{
+					cells_[i].sequence_.store(i, std::memory_order_relaxed);
+				}
+			}
+
+			BoundedQueue(const BoundedQueue& rhs) = delete;
+			BoundedQueue& operator=(const BoundedQueue& rhs) = delete;
+
+			//The value is only moved/copied from when the push succeeds.
+			template <typename U>
+			bool TryEnqueue(U&& value)
+			{
+				Cell* pCell;
+				auto pos = enqueuePos_.load(std::memory_order_relaxed);
+				for (;;)
+				{
+					pCell = &cells_[pos & mask_];
+					auto sequence = pCell->sequence_.load(std::memory_order_acquire);
+					auto diff = static_cast<long long>(sequence) - static_cast<long long>(pos);
+					if (diff == 0)
+					{
+						if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						{
+							break;
+						}
+					}
+					else if (diff < 0)
+					{
+						//full
+						return false;
+					}
+					else
+					{
+						pos = enqueuePos_.load(std::memory_order_relaxed);
+					}
+				}
+
+				pCell->data_ = std::forward<U>(value);
+				pCell->sequence_.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+
+			//Claim as many consecutive free cells as possible, up to count, with a single CAS and fill the i-th one with factory(i).
+			//Return the number of values pushed, 0 when the queue is full.
+			template <typename TFactory>
+			size_t TryEnqueueRange(size_t count, TFactory factory)
+			{
+				if (count == 0)
+				{
+					return 0;
+				}
+
+				size_t pos;
+				size_t available;
+				for (;;)
+				{
+					pos = enqueuePos_.load(std::memory_order_relaxed);
+					available = 0;
+					while (available < count && available <= mask_ && cells_[(pos + available) & mask_].sequence_.load(std::memory_order_acquire) == pos + available)
+					{
+						available++;
+					}
+
+					if (available == 0)
+					{
+						auto diff = static_cast<long long>(cells_[pos & mask_].sequence_.load(std::memory_order_acquire)) - static_cast<long long>(pos);
+						if (diff < 0)
+						{
+							//full
+							return 0;
+						}
+
+						//another producer moved the position
+						continue;
+					}
+
+					if (enqueuePos_.compare_exchange_weak(pos, pos + available, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+
+				for (size_t i = 0; i < available; i++)
+				{
+					auto& cell = cells_[(pos + i) & mask_];
+					cell.data_ = factory(i);
+					cell.sequence_.store(pos + i + 1, std::memory_order_release);
+				}
+
+				return available;
+			}
+
+			bool TryDequeue(T& value)
+			{
+				Cell* pCell;
+				auto pos = dequeuePos_.load(std::memory_order_relaxed);
+				for (;;)
+				{
+					pCell = &cells_[pos & mask_];
+					auto sequence = pCell->sequence_.load(std::memory_order_acquire);
+					auto diff = static_cast<long long>(sequence) - static_cast<long long>(pos + 1);
+					if (diff == 0)
+					{
+						if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						{
+							break;
+						}
+					}
+					else if (diff < 0)
+					{
+						//empty
+						return false;
+					}
+					else
+					{
+						pos = dequeuePos_.load(std::memory_order_relaxed);
+					}
+				}
+
+				value = std::move(pCell->data_);
+				//Release whatever the cell still references before handing it back to producers
+				pCell->data_ = T();
+				pCell->sequence_.store(pos + mask_ + 1, std::memory_order_release);
+				return true;
+			}
+
+			//A push that has claimed its slot but not yet published it is counted, so this may briefly report work that TryDequeue cannot return yet.
+			size_t GetApproximateSize() const
+			{
+				auto dequeuePos = dequeuePos_.load();
+				auto enqueuePos = enqueuePos_.load();
+				return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+			}
+
+			bool IsEmpty() const
+			{
+				return GetApproximateSize() == 0;
+			}
+
+			size_t GetCapacity() const
+			{
+				return mask_ + 1;
+			}
+
+		private:
+			struct Cell
+			{
+				std::atomic<size_t> sequence_;
+				T data_;
+			};
+
+			//Keep the producer and the consumer positions on separate cache lines
+			char padding0_[64];
+			std::unique_ptr<Cell[]> cells_;
+			size_t mask_;
+			char padding1_[64];
+			std::atomic<size_t> enqueuePos_;
+			char padding2_[64];
+			std::atomic<size_t> dequeuePos_;
+			char padding3_[64];
+		};
+	}
+}
\ No newline at end of file
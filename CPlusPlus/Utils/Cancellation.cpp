@@ -0,0 +1,109 @@
+#include "stdafx.h"
+#include "Cancellation.h"
+
+using namespace std;
+
+namespace utils
+{
+	namespace thread_management
+	{
+		CancellationToken::CancellationToken()
+		{
+		}
+
+		CancellationToken::CancellationToken(shared_ptr<CancellationState> pState)
+			:
+			pState_(pState)
+		{
+		}
+
+		bool CancellationToken::CanBeCancelled() const
+		{
+			return pState_ != nullptr;
+		}
+
+		unsigned long long CancellationToken::Register(function<void()> callback) const
+		{
+			if (!pState_ || !callback)
+			{
+				return 0;
+			}
+
+			{
+				lock_guard<mutex> lock(pState_->mutex_);
+				if (!pState_->cancelled_.load())
+				{
+					auto id = pState_->nextId_++;
+					pState_->callbacks_.push_back(make_pair(id, callback));
+					return id;
+				}
+			}
+
+			callback();
+			return 0;
+		}
+
+		bool CancellationToken::Unregister(const unsigned long long& id) const
+		{
+			if (!pState_)
+			{
+				return false;
+			}
+
+			lock_guard<mutex> lock(pState_->mutex_);
+			auto& callbacks = pState_->callbacks_;
+			auto it = find_if(callbacks.begin(), callbacks.end(), [&id](const pair<unsigned long long, function<void()>>& callback) { return callback.first == id; });
+			if (it == callbacks.end())
+			{
+				return false;
+			}
+
+			callbacks.erase(it);
+			return true;
+		}
+
+		CancellationSource::CancellationSource()
+			:
+			pState_(make_shared<CancellationState>())
+		{
+		}
+
+		bool CancellationSource::Cancel()
+		{
+			vector<pair<unsigned long long, function<void()>>> callbacks;
+			{
+				lock_guard<mutex> lock(pState_->mutex_);
+				if (pState_->cancelled_.exchange(true))
+				{
+					return false;
+				}
+
+				callbacks.swap(pState_->callbacks_);
+			}
+
+			for (auto& callback : callbacks)
+			{
+				try
+				{
+					callback.second();
+				}
+				catch (...)
+				{
+					//Log the callback failed, the others still run
+				}
+			}
+
+			return true;
+		}
+
+		bool CancellationSource::IsCancellationRequested() const
+		{
+			return pState_->cancelled_.load();
+		}
+
+		CancellationToken CancellationSource::GetToken() const
+		{
+			return CancellationToken(pState_);
+		}
+	}
+}
\ No newline at end of file
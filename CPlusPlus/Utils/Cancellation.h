@@ -0,0 +1,62 @@
+#pragma once
+
+namespace utils
+{
+	namespace thread_management
+	{
+		//State shared by a CancellationSource and its tokens.
+		struct CancellationState
+		{
+			CancellationState()
+				: cancelled_(false),
+				nextId_(1)
+			{}
+
+			std::atomic<bool> cancelled_;
+			std::mutex mutex_;
+			std::vector<std::pair<unsigned long long, std::function<void()>>> callbacks_;
+			unsigned long long nextId_;
+		};
+
+		//Read side of a CancellationSource, cheap to copy and to poll.
+		//A default constructed token is never cancelled.
+		class CancellationToken
+		{
+		public:
+			CancellationToken();
+
+			bool IsCancellationRequested() const
+			{
+				return pState_ && pState_->cancelled_.load(std::memory_order_acquire);
+			}
+
+			bool CanBeCancelled() const;
+			//Run callback once cancellation is requested, in the thread calling Cancel, or right away if it already was.
+			//Return an id for Unregister, 0 when the callback already ran or the token can never be cancelled.
+			unsigned long long Register(std::function<void()> callback) const;
+			//Return false when the callback is not registered (anymore), it may then have run or be running.
+			bool Unregister(const unsigned long long& id) const;
+
+		private:
+			friend class CancellationSource;
+
+			explicit CancellationToken(std::shared_ptr<CancellationState> pState);
+
+			std::shared_ptr<CancellationState> pState_;
+		};
+
+		class CancellationSource
+		{
+		public:
+			CancellationSource();
+
+			//Request cancellation and run the registered callbacks in this thread. Return false if it was already requested.
+			bool Cancel();
+			bool IsCancellationRequested() const;
+			CancellationToken GetToken() const;
+
+		private:
+			std::shared_ptr<CancellationState> pState_;
+		};
+	}
+}
\ No newline at end of file
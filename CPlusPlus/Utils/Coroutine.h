@@ -0,0 +1,460 @@
+#pragma once
+#include "Task.h"
+#include "ThreadPool.h"
+#include "Scheduler.h"
+
+//Coroutine support needs a compiler in C++20 mode (/std:c++20), the header is empty otherwise.
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#include <optional>
+
+namespace utils
+{
+	namespace thread_management
+	{
+		//co_await pool.Schedule() suspends the coroutine and resumes it on one of the pool's workers.
+		//When the pool is full, a coroutine already on one of its workers goes on there rather than nesting its frames through an inline Post,
+		//any other thread waits for room. If the pool is stopped the co_await throws std::runtime_error.
+		class ScheduleAwaiter
+		{
+		public:
+			ScheduleAwaiter(ThreadPool& pool, const TaskPriority& priority)
+				: pPool_(&pool),
+				priority_(priority),
+				refused_(false)
+			{}
+
+			bool await_ready() const
+			{
+				return false;
+			}
+
+			bool await_suspend(std::coroutine_handle<> handle)
+			{
+				//The coroutine may already run on a worker when the call is posted, this must not be touched after it
+				if (pPool_->TryPost([handle]() { handle.resume(); }, priority_))
+				{
+					return true;
+				}
+
+				if (pPool_->IsCurrentWorker() && !pPool_->IsStopped())
+				{
+					return false;
+				}
+
+				if (pPool_->Post([handle]() { handle.resume(); }, priority_))
+				{
+					return true;
+				}
+
+				refused_ = true;
+				return false;
+			}
+
+			void await_resume() const
+			{
+				if (refused_)
+				{
+					throw std::runtime_error("Fail to schedule the coroutine, the pool is stopped");
+				}
+			}
+
+		private:
+			ThreadPool* pPool_;
+			TaskPriority priority_;
+			bool refused_;
+		};
+
+		inline ScheduleAwaiter ThreadPool::Schedule(const TaskPriority& priority)
+		{
+			return ScheduleAwaiter(*this, priority);
+		}
+
+		//co_await scheduler.SleepFor(duration) resumes the coroutine on the scheduler's pool once the time is reached, no thread waits meanwhile.
+		//The co_await throws std::runtime_error if the wake up never runs: the scheduler refuses it (full or stopped),
+		//or drops it because the scheduler or its pool stops first. The coroutine is then resumed by the thread dropping the wake up,
+		//so that its frame unwinds and is freed by its owner as usual.
+		class SleepAwaiter
+		{
+		public:
+			SleepAwaiter(Scheduler& scheduler, const std::chrono::system_clock::time_point& wakeTime)
+				: pScheduler_(&scheduler),
+				wakeTime_(wakeTime),
+				dropped_(false)
+			{}
+
+			bool await_ready() const
+			{
+				return wakeTime_ <= std::chrono::system_clock::now();
+			}
+
+			bool await_suspend(std::coroutine_handle<> handle)
+			{
+				//The guard is shared by the copies of the wake up task, the last one to go resumes the coroutine if none ran
+				auto pWake = std::make_shared<Wake>(handle, &dropped_);
+				auto pGuard = std::make_shared<WakeGuard>(pWake);
+				pScheduler_->RunTaskAt(wakeTime_, std::make_shared<Task>([pGuard]()
+				{
+					pGuard->pWake_->step_ = WakeResumed;
+					pGuard->pWake_->handle_.resume();
+				}, "SleepAwaiter"));
+				pGuard.reset();
+
+				//A refused task is gone by now and left the coroutine to this call. Once armed, the coroutine may already run elsewhere: this must not be touched.
+				auto step = WakeArming;
+				if (pWake->step_.compare_exchange_strong(step, WakeArmed) || step == WakeResumed)
+				{
+					return true;
+				}
+
+				dropped_ = true;
+				return false;
+			}
+
+			void await_resume() const
+			{
+				if (dropped_)
+				{
+					throw std::runtime_error("Fail to sleep, the scheduler dropped the wake up");
+				}
+			}
+
+		private:
+			enum WakeStep
+			{
+				//await_suspend has not returned yet
+				WakeArming,
+				WakeArmed,
+				WakeResumed,
+				//Dropped while arming, await_suspend goes on without suspending
+				WakeDropped
+			};
+
+			struct Wake
+			{
+				Wake(std::coroutine_handle<> handle, bool* pDropped)
+					: step_(WakeArming),
+					handle_(handle),
+					pDropped_(pDropped)
+				{}
+
+				std::atomic<WakeStep> step_;
+				std::coroutine_handle<> handle_;
+				bool* pDropped_;
+			};
+
+			//Owned by the wake up task, resumes the coroutine with an error when the task goes without having run
+			struct WakeGuard
+			{
+				explicit WakeGuard(std::shared_ptr<Wake> pWake)
+					: pWake_(pWake)
+				{}
+
+				~WakeGuard()
+				{
+					auto step = WakeArmed;
+					if (pWake_->step_.compare_exchange_strong(step, WakeResumed))
+					{
+						*pWake_->pDropped_ = true;
+						pWake_->handle_.resume();
+						return;
+					}
+
+					step = WakeArming;
+					pWake_->step_.compare_exchange_strong(step, WakeDropped);
+				}
+
+				std::shared_ptr<Wake> pWake_;
+			};
+
+			Scheduler* pScheduler_;
+			std::chrono::system_clock::time_point wakeTime_;
+			bool dropped_;
+		};
+
+		inline SleepAwaiter Scheduler::SleepFor(const std::chrono::system_clock::duration& duration)
+		{
+			return SleepAwaiter(*this, std::chrono::system_clock::now() + duration);
+		}
+
+		inline SleepAwaiter Scheduler::SleepUntil(const std::chrono::system_clock::time_point& time)
+		{
+			return SleepAwaiter(*this, time);
+		}
+
+		//Promise of a CoTask: the body only starts when the task is awaited, and its end resumes the awaiting coroutine by symmetric transfer,
+		//so a chain of CoTask neither allocates beyond the coroutine frames nor grows the stack.
+		class CoTaskPromiseBase
+		{
+		public:
+			struct FinalAwaiter
+			{
+				bool await_ready() const noexcept
+				{
+					return false;
+				}
+
+				template <typename TPromise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> handle) noexcept
+				{
+					auto continuation = handle.promise().continuation_;
+					return continuation ? continuation : std::noop_coroutine();
+				}
+
+				void await_resume() const noexcept
+				{
+				}
+			};
+
+			std::suspend_always initial_suspend() const noexcept
+			{
+				return std::suspend_always();
+			}
+
+			FinalAwaiter final_suspend() const noexcept
+			{
+				return FinalAwaiter();
+			}
+
+			void unhandled_exception()
+			{
+				exception_ = std::current_exception();
+			}
+
+			std::coroutine_handle<> continuation_;
+			std::exception_ptr exception_;
+		};
+
+		template <typename T>
+		class CoTask;
+
+		template <typename T>
+		class CoTaskPromise : public CoTaskPromiseBase
+		{
+		public:
+			CoTask<T> get_return_object();
+
+			template <typename U>
+			void return_value(U&& value)
+			{
+				value_.emplace(std::forward<U>(value));
+			}
+
+			T GetResult()
+			{
+				if (exception_)
+				{
+					std::rethrow_exception(exception_);
+				}
+
+				return std::move(*value_);
+			}
+
+		private:
+			std::optional<T> value_;
+		};
+
+		template <>
+		class CoTaskPromise<void> : public CoTaskPromiseBase
+		{
+		public:
+			CoTask<void> get_return_object();
+
+			void return_void()
+			{
+			}
+
+			void GetResult()
+			{
+				if (exception_)
+				{
+					std::rethrow_exception(exception_);
+				}
+			}
+		};
+
+		//Lazy coroutine returning T. co_await it from another coroutine to run it and get its result or its exception,
+		//or hand it to Spawn or SyncWait from plain code.
+		template <typename T = void>
+		class CoTask
+		{
+		public:
+			typedef CoTaskPromise<T> promise_type;
+
+			explicit CoTask(std::coroutine_handle<promise_type> handle)
+				: handle_(handle)
+			{}
+
+			CoTask(CoTask&& rhs)
+				: handle_(rhs.handle_)
+			{
+				rhs.handle_ = nullptr;
+			}
+
+			CoTask& operator=(CoTask&& rhs)
+			{
+				if (this != &rhs)
+				{
+					if (handle_)
+					{
+						handle_.destroy();
+					}
+
+					handle_ = rhs.handle_;
+					rhs.handle_ = nullptr;
+				}
+
+				return *this;
+			}
+
+			~CoTask()
+			{
+				if (handle_)
+				{
+					handle_.destroy();
+				}
+			}
+
+			CoTask(const CoTask& rhs) = delete;
+			CoTask& operator=(const CoTask& rhs) = delete;
+
+			bool await_ready() const
+			{
+				return !handle_ || handle_.done();
+			}
+
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation)
+			{
+				handle_.promise().continuation_ = continuation;
+				return handle_;
+			}
+
+			T await_resume()
+			{
+				return handle_.promise().GetResult();
+			}
+
+			bool IsDone() const
+			{
+				return !handle_ || handle_.done();
+			}
+
+			//The result once IsDone(), rethrows the exception the body ended with.
+			T GetResult()
+			{
+				return handle_.promise().GetResult();
+			}
+
+			//Awaitable that runs the task without taking its result.
+			class ReadyAwaiter
+			{
+			public:
+				explicit ReadyAwaiter(CoTask& task)
+					: pTask_(&task)
+				{}
+
+				bool await_ready() const
+				{
+					return pTask_->IsDone();
+				}
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation)
+				{
+					return pTask_->await_suspend(continuation);
+				}
+
+				void await_resume() const
+				{
+				}
+
+			private:
+				CoTask* pTask_;
+			};
+
+			ReadyAwaiter WhenReady()
+			{
+				return ReadyAwaiter(*this);
+			}
+
+		private:
+			std::coroutine_handle<promise_type> handle_;
+		};
+
+		template <typename T>
+		inline CoTask<T> CoTaskPromise<T>::get_return_object()
+		{
+			return CoTask<T>(std::coroutine_handle<CoTaskPromise<T>>::from_promise(*this));
+		}
+
+		inline CoTask<void> CoTaskPromise<void>::get_return_object()
+		{
+			return CoTask<void>(std::coroutine_handle<CoTaskPromise<void>>::from_promise(*this));
+		}
+
+		//Eager coroutine that frees its own frame when it ends, used to start a CoTask from plain code.
+		struct DetachedCoroutine
+		{
+			struct promise_type
+			{
+				DetachedCoroutine get_return_object() const
+				{
+					return DetachedCoroutine();
+				}
+
+				std::suspend_never initial_suspend() const noexcept
+				{
+					return std::suspend_never();
+				}
+
+				std::suspend_never final_suspend() const noexcept
+				{
+					return std::suspend_never();
+				}
+
+				void return_void() const
+				{
+				}
+
+				void unhandled_exception() const
+				{
+					//Swallowed like the exceptions of the pool's tasks
+				}
+			};
+		};
+
+		//Run the task until its first suspension in the calling thread and let it finish on its own, its exception is dropped.
+		inline DetachedCoroutine Spawn(CoTask<void> task)
+		{
+			co_await task;
+		}
+
+		//Block the calling thread until the task finished and return its result. Do not call it from a worker of the pool the task runs on.
+		template <typename T>
+		T SyncWait(CoTask<T> task)
+		{
+			std::mutex mutex;
+			std::condition_variable cdv;
+			auto done = false;
+
+			auto notify = [](CoTask<T>& task, std::mutex& mutex, std::condition_variable& cdv, bool& done) -> DetachedCoroutine
+			{
+				co_await task.WhenReady();
+				std::lock_guard<std::mutex> lock(mutex);
+				done = true;
+				cdv.notify_all();
+			};
+			notify(task, mutex, cdv, done);
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (!done)
+				{
+					cdv.wait(lock);
+				}
+			}
+
+			return task.GetResult();
+		}
+	}
+}
+#endif
\ No newline at end of file
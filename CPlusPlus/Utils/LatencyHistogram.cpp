@@ -0,0 +1,278 @@
+#include "stdafx.h"
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+namespace utils
+{
+	namespace thread_management
+	{
+		LatencySnapshot::LatencySnapshot()
+			:
+			counts_(LatencyBuckets::BucketCount, 0),
+			count_(0),
+			sum_(0)
+		{
+		}
+
+		void LatencySnapshot::Add(const LatencySnapshot& rhs)
+		{
+			for (unsigned int i = 0; i < LatencyBuckets::BucketCount; i++)
+			{
+				counts_[i] += rhs.counts_[i];
+			}
+
+			count_ += rhs.count_;
+			sum_ += rhs.sum_;
+		}
+
+		unsigned long long LatencySnapshot::GetCount() const
+		{
+			return count_;
+		}
+
+		chrono::nanoseconds LatencySnapshot::GetMean() const
+		{
+			return chrono::nanoseconds(count_ == 0 ? 0 : sum_ / count_);
+		}
+
+		chrono::nanoseconds LatencySnapshot::GetMin() const
+		{
+			for (unsigned int i = 0; i < LatencyBuckets::BucketCount; i++)
+			{
+				if (counts_[i] > 0)
+				{
+					return chrono::nanoseconds(LatencyBuckets::GetLowerBound(i));
+				}
+			}
+
+			return chrono::nanoseconds(0);
+		}
+
+		chrono::nanoseconds LatencySnapshot::GetMax() const
+		{
+			for (auto i = LatencyBuckets::BucketCount; i > 0; i--)
+			{
+				if (counts_[i - 1] > 0)
+				{
+					return chrono::nanoseconds(LatencyBuckets::GetUpperBound(i - 1));
+				}
+			}
+
+			return chrono::nanoseconds(0);
+		}
+
+		chrono::nanoseconds LatencySnapshot::GetPercentile(const double& percentile) const
+		{
+			if (count_ == 0)
+			{
+				return chrono::nanoseconds(0);
+			}
+
+			//Rank of the value, at least the first one
+			auto rank = static_cast<unsigned long long>(ceil(min(max(percentile, 0.0), 100.0) / 100.0 * count_));
+			rank = max(rank, 1ULL);
+
+			unsigned long long seen = 0;
+			for (unsigned int i = 0; i < LatencyBuckets::BucketCount; i++)
+			{
+				seen += counts_[i];
+				if (seen >= rank)
+				{
+					return chrono::nanoseconds(LatencyBuckets::GetUpperBound(i));
+				}
+			}
+
+			return GetMax();
+		}
+
+		const vector<unsigned long long>& LatencySnapshot::GetCounts() const
+		{
+			return counts_;
+		}
+
+		LatencyHistogram::LatencyHistogram()
+			:
+			sum_(0)
+		{
+			for (auto& chunk : chunks_)
+			{
+				chunk.store(nullptr);
+			}
+		}
+
+		LatencyHistogram::~LatencyHistogram()
+		{
+			for (auto& chunk : chunks_)
+			{
+				delete[] chunk.load();
+			}
+		}
+
+		atomic<unsigned long long>* LatencyHistogram::AllocateChunk(const unsigned int& chunk)
+		{
+			auto pCounts = new atomic<unsigned long long>[LatencyBuckets::SubBucketCount];
+			for (unsigned int i = 0; i < LatencyBuckets::SubBucketCount; i++)
+			{
+				pCounts[i].store(0, memory_order_relaxed);
+			}
+
+			//Publish the zeroed counts to the readers
+			chunks_[chunk].store(pCounts, memory_order_release);
+			return pCounts;
+		}
+
+		void LatencyHistogram::Clear()
+		{
+			for (auto& chunk : chunks_)
+			{
+				auto pCounts = chunk.load(memory_order_relaxed);
+				if (pCounts)
+				{
+					for (unsigned int i = 0; i < LatencyBuckets::SubBucketCount; i++)
+					{
+						pCounts[i].store(0, memory_order_relaxed);
+					}
+				}
+			}
+
+			sum_.store(0, memory_order_relaxed);
+		}
+
+		void LatencyHistogram::CopyTo(LatencySnapshot& snapshot) const
+		{
+			for (unsigned int chunk = 0; chunk < LatencyBuckets::ChunkCount; chunk++)
+			{
+				auto pCounts = chunks_[chunk].load(memory_order_acquire);
+				if (!pCounts)
+				{
+					continue;
+				}
+
+				for (unsigned int i = 0; i < LatencyBuckets::SubBucketCount; i++)
+				{
+					auto count = pCounts[i].load(memory_order_relaxed);
+					snapshot.counts_[chunk * LatencyBuckets::SubBucketCount + i] += count;
+					snapshot.count_ += count;
+				}
+			}
+
+			snapshot.sum_ += sum_.load(memory_order_relaxed);
+		}
+
+		LatencyRecorder::LatencyRecorder()
+			:
+			epoch_(0)
+		{
+			for (auto& page : pages_)
+			{
+				page.store(nullptr);
+			}
+		}
+
+		LatencyRecorder::~LatencyRecorder()
+		{
+			for (auto& page : pages_)
+			{
+				auto pPage = page.load();
+				if (!pPage)
+				{
+					continue;
+				}
+
+				for (unsigned int i = 0; i < NamePageSize; i++)
+				{
+					delete pPage[i].load();
+				}
+
+				delete[] pPage;
+			}
+		}
+
+		LatencyRecorder::NameLatency* LatencyRecorder::AllocateName(const unsigned int& nameId)
+		{
+			auto& page = pages_[(nameId / NamePageSize) % NamePageCount];
+			auto pPage = page.load(memory_order_relaxed);
+			if (!pPage)
+			{
+				pPage = new atomic<NameLatency*>[NamePageSize];
+				for (unsigned int i = 0; i < NamePageSize; i++)
+				{
+					pPage[i].store(nullptr, memory_order_relaxed);
+				}
+
+				page.store(pPage, memory_order_release);
+			}
+
+			auto pName = new NameLatency();
+			pPage[nameId % NamePageSize].store(pName, memory_order_release);
+			return pName;
+		}
+
+		void LatencyRecorder::Clear(const unsigned long long& epoch)
+		{
+			//Readers skip this recorder until the new epoch is published
+			wait_.Clear();
+			run_.Clear();
+			for (auto& page : pages_)
+			{
+				auto pPage = page.load(memory_order_relaxed);
+				if (!pPage)
+				{
+					continue;
+				}
+
+				for (unsigned int i = 0; i < NamePageSize; i++)
+				{
+					auto pName = pPage[i].load(memory_order_relaxed);
+					if (pName)
+					{
+						pName->wait_.Clear();
+						pName->run_.Clear();
+					}
+				}
+			}
+
+			epoch_.store(epoch, memory_order_release);
+		}
+
+		void LatencyRecorder::CopyTo(const unsigned long long& epoch, LatencyReport& report) const
+		{
+			if (epoch_.load(memory_order_acquire) != epoch)
+			{
+				return;
+			}
+
+			wait_.CopyTo(report.wait_);
+			run_.CopyTo(report.run_);
+		}
+
+		void LatencyRecorder::CopyTo(const unsigned long long& epoch, unordered_map<unsigned int, LatencyReport>& reports) const
+		{
+			if (epoch_.load(memory_order_acquire) != epoch)
+			{
+				return;
+			}
+
+			for (unsigned int page = 0; page < NamePageCount; page++)
+			{
+				auto pPage = pages_[page].load(memory_order_acquire);
+				if (!pPage)
+				{
+					continue;
+				}
+
+				for (unsigned int i = 0; i < NamePageSize; i++)
+				{
+					auto pName = pPage[i].load(memory_order_acquire);
+					if (pName)
+					{
+						auto& report = reports[page * NamePageSize + i];
+						pName->wait_.CopyTo(report.wait_);
+						pName->run_.CopyTo(report.run_);
+					}
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
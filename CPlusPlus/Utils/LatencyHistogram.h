@@ -0,0 +1,201 @@
+#pragma once
+
+namespace utils
+{
+	namespace thread_management
+	{
+		//Log-linear buckets of nanosecond durations, in the way of HDR histograms.
+		//Values below SubBucketCount are exact, above that every power of two is split in SubBucketCount linear buckets,
+		//so a bucket is never wider than 1/16 of its values. Durations of 2^MaxExponent ns (about 18 minutes) and more share the last bucket.
+		struct LatencyBuckets
+		{
+			static const unsigned int SubBucketBits = 4;
+			static const unsigned int SubBucketCount = 1 << SubBucketBits;
+			static const unsigned int MaxExponent = 40;
+			//One chunk of SubBucketCount buckets per power of two, the first one holding the exact values
+			static const unsigned int ChunkCount = MaxExponent - SubBucketBits + 1;
+			static const unsigned int BucketCount = ChunkCount * SubBucketCount;
+
+			static unsigned int GetIndex(const unsigned long long& value)
+			{
+				if (value < SubBucketCount)
+				{
+					return static_cast<unsigned int>(value);
+				}
+
+				unsigned long exponent;
+				if (_BitScanReverse(&exponent, static_cast<unsigned long>(value >> 32)))
+				{
+					exponent += 32;
+				}
+				else
+				{
+					_BitScanReverse(&exponent, static_cast<unsigned long>(value));
+				}
+
+				if (exponent >= MaxExponent)
+				{
+					return BucketCount - 1;
+				}
+
+				return (exponent - SubBucketBits + 1) * SubBucketCount + static_cast<unsigned int>((value >> (exponent - SubBucketBits)) - SubBucketCount);
+			}
+
+			static unsigned long long GetLowerBound(const unsigned int& index)
+			{
+				auto chunk = index / SubBucketCount;
+				if (chunk == 0)
+				{
+					return index;
+				}
+
+				return static_cast<unsigned long long>(SubBucketCount + index % SubBucketCount) << (chunk - 1);
+			}
+
+			static unsigned long long GetUpperBound(const unsigned int& index)
+			{
+				auto chunk = index / SubBucketCount;
+				if (chunk == 0)
+				{
+					return index;
+				}
+
+				return GetLowerBound(index) + (1ULL << (chunk - 1)) - 1;
+			}
+		};
+
+		//Plain copy of histogram counts, merged from any number of LatencyHistogram.
+		class LatencySnapshot
+		{
+		public:
+			LatencySnapshot();
+
+			void Add(const LatencySnapshot& rhs);
+
+			unsigned long long GetCount() const;
+			std::chrono::nanoseconds GetMean() const;
+			//Min, max and percentiles are only as precise as the buckets: the lower bound of the lowest bucket,
+			//the upper bound of the highest one and of the bucket holding the percentile.
+			std::chrono::nanoseconds GetMin() const;
+			std::chrono::nanoseconds GetMax() const;
+			//percentile in [0, 100]
+			std::chrono::nanoseconds GetPercentile(const double& percentile) const;
+			//Count of every bucket, see LatencyBuckets for their bounds.
+			const std::vector<unsigned long long>& GetCounts() const;
+
+		private:
+			friend class LatencyHistogram;
+
+			std::vector<unsigned long long> counts_;
+			unsigned long long count_;
+			unsigned long long sum_;
+		};
+
+		//Histogram written by a single thread without any lock or interlocked operation, readers may copy it at any time.
+		//The buckets are allocated a power of two at a time when first hit, so a histogram of similar durations stays small.
+		class LatencyHistogram
+		{
+		public:
+			LatencyHistogram();
+			~LatencyHistogram();
+
+			void Record(const unsigned long long& nanoseconds)
+			{
+				auto index = LatencyBuckets::GetIndex(nanoseconds);
+				auto chunk = index / LatencyBuckets::SubBucketCount;
+				auto pCounts = chunks_[chunk].load(std::memory_order_acquire);
+				if (!pCounts)
+				{
+					pCounts = AllocateChunk(chunk);
+				}
+
+				auto& count = pCounts[index % LatencyBuckets::SubBucketCount];
+				count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				sum_.store(sum_.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+			}
+
+			//Zero the counts, only the recording thread may call it.
+			void Clear();
+			//Add the counts to the snapshot.
+			void CopyTo(LatencySnapshot& snapshot) const;
+
+			LatencyHistogram& operator=(const LatencyHistogram& rhs) = delete;
+			LatencyHistogram(const LatencyHistogram& rhs) = delete;
+
+		private:
+			std::atomic<unsigned long long>* AllocateChunk(const unsigned int& chunk);
+
+			std::atomic<std::atomic<unsigned long long>*> chunks_[LatencyBuckets::ChunkCount];
+			std::atomic<unsigned long long> sum_;
+		};
+
+		struct LatencyReport
+		{
+			//Time from enqueue to dispatch
+			LatencySnapshot wait_;
+			//Time from dispatch to completion
+			LatencySnapshot run_;
+		};
+
+		//Queue wait and run time histograms of one worker, in total and per task name id.
+		//Histograms are reset lazily: the owner clears them on its next Record after the epoch moved on,
+		//until then readers asking for the new epoch skip them.
+		class LatencyRecorder
+		{
+		public:
+			LatencyRecorder();
+			~LatencyRecorder();
+
+			//Only the owning worker records.
+			void Record(const unsigned long long& epoch, const unsigned int& nameId, const unsigned long long& waitTime, const unsigned long long& runTime)
+			{
+				if (epoch_.load(std::memory_order_relaxed) != epoch)
+				{
+					Clear(epoch);
+				}
+
+				wait_.Record(waitTime);
+				run_.Record(runTime);
+
+				if (nameId != 0)
+				{
+					auto pName = GetName(nameId);
+					pName->wait_.Record(waitTime);
+					pName->run_.Record(runTime);
+				}
+			}
+
+			void CopyTo(const unsigned long long& epoch, LatencyReport& report) const;
+			void CopyTo(const unsigned long long& epoch, std::unordered_map<unsigned int, LatencyReport>& reports) const;
+
+			LatencyRecorder& operator=(const LatencyRecorder& rhs) = delete;
+			LatencyRecorder(const LatencyRecorder& rhs) = delete;
+
+		private:
+			struct NameLatency
+			{
+				LatencyHistogram wait_;
+				LatencyHistogram run_;
+			};
+
+			//Name ids are looked up in pages of NamePageSize entries allocated on first use
+			static const unsigned int NamePageSize = 256;
+			static const unsigned int NamePageCount = 256;
+
+			NameLatency* GetName(const unsigned int& nameId)
+			{
+				auto pPage = pages_[(nameId / NamePageSize) % NamePageCount].load(std::memory_order_acquire);
+				auto pName = pPage ? pPage[nameId % NamePageSize].load(std::memory_order_acquire) : nullptr;
+				return pName ? pName : AllocateName(nameId);
+			}
+
+			NameLatency* AllocateName(const unsigned int& nameId);
+			void Clear(const unsigned long long& epoch);
+
+			LatencyHistogram wait_;
+			LatencyHistogram run_;
+			std::atomic<std::atomic<NameLatency*>*> pages_[NamePageCount];
+			std::atomic<unsigned long long> epoch_;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "stdafx.h"
+#include "ParallelAlgorithms.h"
+
+using namespace std;
+
+namespace utils
+{
+	namespace thread_management
+	{
+		namespace
+		{
+			//With automatic partitioning no chunk is smaller than 1/MinChunkDivisor of a participant's share
+			const size_t MinChunkDivisor = 32;
+
+			//State shared by the caller and the helpers of one ParallelRange call.
+			//Helpers that start after the range is done only find the cursor at the end, they never touch the body.
+			struct RangeJob
+			{
+				RangeJob(const function<void(size_t, size_t)>& body, const size_t& count, const size_t& grainSize, const size_t& participantCount)
+					: pBody_(&body),
+					count_(count),
+					grainSize_(grainSize),
+					participantCount_(participantCount),
+					next_(0),
+					doneCount_(0),
+					failed_(false)
+				{}
+
+				const function<void(size_t, size_t)>* pBody_;
+				size_t count_;
+				//Fixed chunk size, or 0 for guided chunks
+				size_t grainSize_;
+				size_t participantCount_;
+				atomic<size_t> next_;
+				atomic<size_t> doneCount_;
+				atomic<bool> failed_;
+				exception_ptr exception_;
+				mutex mutex_;
+				condition_variable cdv_;
+			};
+
+			size_t GetMinChunkSize(const size_t& count, const size_t& participantCount)
+			{
+				return max<size_t>(1, count / (participantCount * MinChunkDivisor));
+			}
+
+			//Claim the next chunk and run it, return false once the range is exhausted
+			bool RunChunk(RangeJob& job)
+			{
+				size_t begin = job.next_.load(memory_order_relaxed);
+				size_t end;
+				do
+				{
+					if (begin >= job.count_)
+					{
+						return false;
+					}
+
+					//Guided: half of an even share of what is left, so the last chunks are small enough to balance the load
+					auto size = (job.grainSize_ != 0) ? job.grainSize_ : max(GetMinChunkSize(job.count_, job.participantCount_), (job.count_ - begin) / (2 * job.participantCount_));
+					end = min(job.count_, begin + size);
+				} while (!job.next_.compare_exchange_weak(begin, end, memory_order_relaxed));
+
+				if (!job.failed_.load(memory_order_relaxed))
+				{
+					try
+					{
+						(*job.pBody_)(begin, end);
+					}
+					catch (...)
+					{
+						lock_guard<mutex> lock(job.mutex_);
+						if (!job.exception_)
+						{
+							job.exception_ = current_exception();
+						}
+						job.failed_ = true;
+					}
+				}
+
+				if (job.doneCount_.fetch_add(end - begin) + (end - begin) == job.count_)
+				{
+					lock_guard<mutex> lock(job.mutex_);
+					job.cdv_.notify_all();
+				}
+
+				return true;
+			}
+		}
+
+		void ParallelRange(ThreadPool& pool, const size_t& count, const function<void(size_t, size_t)>& body, const size_t& grainSize)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			auto participantCount = static_cast<size_t>(pool.GetPoolSize()) + 1;
+			auto pJob = make_shared<RangeJob>(body, count, grainSize, participantCount);
+
+			//No more helpers than chunks beside the caller's, and none when the pool is full: the caller then does the work
+			auto chunkSize = (grainSize != 0) ? grainSize : GetMinChunkSize(count, participantCount);
+			auto helperCount = min(participantCount - 1, (count + chunkSize - 1) / chunkSize - 1);
+			for (size_t i = 0; i < helperCount; i++)
+			{
+				if (!pool.TryPost([pJob]() { while (RunChunk(*pJob)) {} }))
+				{
+					break;
+				}
+			}
+
+			while (RunChunk(*pJob))
+			{
+			}
+
+			//Only chunks already running on other threads are left
+			{
+				unique_lock<mutex> lock(pJob->mutex_);
+				while (pJob->doneCount_.load() != count)
+				{
+					pJob->cdv_.wait(lock);
+				}
+			}
+
+			if (pJob->exception_)
+			{
+				rethrow_exception(pJob->exception_);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+#include "ThreadPool.h"
+
+namespace utils
+{
+	namespace thread_management
+	{
+		//Data parallel algorithms run on a ThreadPool.
+		//The range is cut in chunks that the pool's workers and the calling thread claim from a shared atomic cursor, so the caller always helps
+		//and never waits for a chunk nobody runs: a call made from a task of the same pool cannot deadlock, it at worst runs every chunk itself.
+		//grainSize is the number of elements per chunk, 0 partitions automatically: chunks start large and shrink as the range runs out.
+		//The first exception thrown by the body is rethrown to the caller once the chunks already claimed are done, the others are skipped.
+
+		//Run body(begin, end) over consecutive chunks covering [0, count).
+		void ParallelRange(ThreadPool& pool, const size_t& count, const std::function<void(size_t, size_t)>& body, const size_t& grainSize = 0);
+
+		//body(i) for every i in [first, last)
+		template <typename TIndex, typename TBody>
+		void ParallelFor(ThreadPool& pool, TIndex first, TIndex last, TBody body, const size_t& grainSize = 0)
+		{
+			if (!(first < last))
+			{
+				return;
+			}
+
+			ParallelRange(pool, static_cast<size_t>(last - first), [&](size_t begin, size_t end)
+			{
+				for (auto i = begin; i < end; i++)
+				{
+					body(static_cast<TIndex>(first + i));
+				}
+			}, grainSize);
+		}
+
+		//body(element) for every element of a random access range
+		template <typename TIterator, typename TBody>
+		void ParallelForEach(ThreadPool& pool, TIterator first, TIterator last, TBody body, const size_t& grainSize = 0)
+		{
+			ParallelRange(pool, static_cast<size_t>(std::distance(first, last)), [&](size_t begin, size_t end)
+			{
+				std::for_each(first + begin, first + end, body);
+			}, grainSize);
+		}
+
+		//combine(...combine(combine(identity, map(first)), map(first + 1))..., map(last - 1)).
+		//combine must be associative, the chunk results are combined in index order so it does not have to be commutative.
+		template <typename TIndex, typename T, typename TMap, typename TCombine>
+		T ParallelReduce(ThreadPool& pool, TIndex first, TIndex last, const T& identity, TMap map, TCombine combine, const size_t& grainSize = 0)
+		{
+			if (!(first < last))
+			{
+				return identity;
+			}
+
+			std::mutex mutex;
+			std::vector<std::pair<size_t, T>> results;
+			ParallelRange(pool, static_cast<size_t>(last - first), [&](size_t begin, size_t end)
+			{
+				auto result = identity;
+				for (auto i = begin; i < end; i++)
+				{
+					result = combine(result, map(static_cast<TIndex>(first + i)));
+				}
+
+				std::lock_guard<std::mutex> lock(mutex);
+				results.push_back(std::make_pair(begin, std::move(result)));
+			}, grainSize);
+
+			std::sort(results.begin(), results.end(), [](const std::pair<size_t, T>& left, const std::pair<size_t, T>& right) { return left.first < right.first; });
+
+			auto result = identity;
+			for (auto& chunkResult : results)
+			{
+				result = combine(result, chunkResult.second);
+			}
+
+			return result;
+		}
+
+		//Inclusive scan: out[i] = combine(...combine(identity, first[0])..., first[i]). out may be first.
+		//Two passes over blocks: the block totals are reduced in parallel, prefixed serially, then every block is scanned in parallel from its prefix.
+		template <typename TInputIterator, typename TOutputIterator, typename T, typename TCombine>
+		void ParallelScan(ThreadPool& pool, TInputIterator first, TInputIterator last, TOutputIterator out, const T& identity, TCombine combine, const size_t& grainSize = 0)
+		{
+			auto count = static_cast<size_t>(std::distance(first, last));
+			if (count == 0)
+			{
+				return;
+			}
+
+			auto blockCount = (grainSize == 0) ? std::min<size_t>(count, (pool.GetPoolSize() + 1) * 4) : (count + grainSize - 1) / grainSize;
+			auto blockBegin = [count, blockCount](size_t block) { return block * count / blockCount; };
+
+			std::vector<T> prefixes(blockCount, identity);
+			ParallelRange(pool, blockCount, [&](size_t begin, size_t end)
+			{
+				for (auto block = begin; block < end; block++)
+				{
+					auto total = identity;
+					for (auto i = blockBegin(block); i < blockBegin(block + 1); i++)
+					{
+						total = combine(total, first[i]);
+					}
+					prefixes[block] = std::move(total);
+				}
+			}, 1);
+
+			//Turn the block totals into the value before each block
+			auto prefix = identity;
+			for (auto& blockPrefix : prefixes)
+			{
+				auto total = combine(prefix, blockPrefix);
+				blockPrefix = prefix;
+				prefix = std::move(total);
+			}
+
+			ParallelRange(pool, blockCount, [&](size_t begin, size_t end)
+			{
+				for (auto block = begin; block < end; block++)
+				{
+					auto value = prefixes[block];
+					for (auto i = blockBegin(block); i < blockBegin(block + 1); i++)
+					{
+						value = combine(value, first[i]);
+						out[i] = value;
+					}
+				}
+			}, 1);
+		}
+
+		//Sort blocks in parallel, then merge them pairwise, each round of merges in parallel. Not stable.
+		//grainSize is the smallest block worth sorting on its own, 0 uses 4096 elements.
+		template <typename TIterator, typename TCompare>
+		void ParallelSort(ThreadPool& pool, TIterator first, TIterator last, TCompare compare, const size_t& grainSize = 0)
+		{
+			auto count = static_cast<size_t>(std::distance(first, last));
+			auto minBlockSize = (grainSize == 0) ? static_cast<size_t>(4096) : grainSize;
+
+			//A power of two of blocks, about two per participant
+			size_t blockCount = 1;
+			while (blockCount < 2 * (pool.GetPoolSize() + 1) && count / (blockCount * 2) >= minBlockSize)
+			{
+				blockCount *= 2;
+			}
+
+			if (blockCount == 1)
+			{
+				std::sort(first, last, compare);
+				return;
+			}
+
+			auto blockBegin = [first, count, blockCount](size_t block) { return first + block * count / blockCount; };
+
+			ParallelRange(pool, blockCount, [&](size_t begin, size_t end)
+			{
+				for (auto block = begin; block < end; block++)
+				{
+					std::sort(blockBegin(block), blockBegin(block + 1), compare);
+				}
+			}, 1);
+
+			for (size_t width = 1; width < blockCount; width *= 2)
+			{
+				ParallelRange(pool, blockCount / (2 * width), [&](size_t begin, size_t end)
+				{
+					for (auto merge = begin; merge < end; merge++)
+					{
+						auto block = merge * 2 * width;
+						std::inplace_merge(blockBegin(block), blockBegin(block + width), blockBegin(block + 2 * width), compare);
+					}
+				}, 1);
+			}
+		}
+
+		template <typename TIterator>
+		void ParallelSort(ThreadPool& pool, TIterator first, TIterator last)
+		{
+			ParallelSort(pool, first, last, std::less<typename std::iterator_traits<TIterator>::value_type>());
+		}
+	}
+}
\ No newline at end of file
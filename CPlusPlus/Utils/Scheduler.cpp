@@ -4,18 +4,149 @@
 
 using namespace std;
 
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
 namespace utils
 {
 	namespace thread_management
 	{
-		Scheduler::Scheduler(std::shared_ptr<ThreadPool> pThreadPool, const std::chrono::system_clock::duration& minRecurringInterval, const unsigned int& maxTaskSize, const std::chrono::system_clock::duration& maxDelayTolerance)
-			:stop_(false),
+		namespace
+		{
+			atomic<unsigned int> nextThreadShard(0);
+			//Shard of the calling thread for AnyShard, modulo the shard count
+			thread_local unsigned int threadShard = nextThreadShard++;
+
+			//A high precision wait sleeps on the waitable timer until SpinWindow before the due time and spins from there.
+			//It starts once the due time is PreciseWaitWindow away, before that the thread waits on the condition variable as usual.
+			const chrono::microseconds PreciseWaitWindow(2000);
+			const chrono::microseconds SpinWindow(50);
+
+			chrono::steady_clock::time_point ToSteadyTime(const chrono::system_clock::time_point& time)
+			{
+				auto systemNow = chrono::system_clock::now();
+				auto steadyNow = chrono::steady_clock::now();
+
+				//Beyond 100 years the steady clock may overflow, no task waits that long anyway
+				const chrono::hours maxOffset(100 * 365 * 24);
+				chrono::system_clock::duration offset = maxOffset;
+				if (time < systemNow - maxOffset)
+				{
+					offset = -maxOffset;
+				}
+				else if (time < systemNow + maxOffset)
+				{
+					offset = time - systemNow;
+				}
+
+				return steadyNow + chrono::duration_cast<chrono::steady_clock::duration>(offset);
+			}
+
+			HANDLE CreatePreciseTimer()
+			{
+				//High resolution timers need Windows 10 1803, older systems get a plain one
+				auto hTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+				return hTimer ? hTimer : CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+			}
+
+			void WaitPrecisely(HANDLE hTimer, const chrono::steady_clock::time_point& deadline)
+			{
+				auto sleepTime = deadline - SpinWindow - chrono::steady_clock::now();
+				if (hTimer && sleepTime > chrono::steady_clock::duration(0))
+				{
+					//Negative for a relative time, in 100 nanoseconds
+					LARGE_INTEGER dueTime;
+					dueTime.QuadPart = -static_cast<long long>(chrono::duration_cast<chrono::nanoseconds>(sleepTime).count() / 100);
+					if (SetWaitableTimer(hTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+					{
+						WaitForSingleObject(hTimer, INFINITE);
+					}
+				}
+
+				while (chrono::steady_clock::now() < deadline)
+				{
+					this_thread::yield();
+				}
+			}
+		}
+
+		TimerHandle::TimerHandle()
+			:
+			pScheduler_(nullptr),
+			shard_(0),
+			timerId_(InvalidTimerId)
+		{
+		}
+
+		TimerHandle::TimerHandle(Scheduler* pScheduler, const unsigned int& shard, const TimerId& timerId)
+			:
+			pScheduler_(pScheduler),
+			shard_(shard),
+			timerId_(timerId)
+		{
+		}
+
+		bool TimerHandle::Cancel()
+		{
+			return IsValid() && pScheduler_->CancelTimer(shard_, timerId_);
+		}
+
+		bool TimerHandle::Reschedule(const chrono::system_clock::time_point& startTime)
+		{
+			return IsValid() && pScheduler_->RescheduleTimer(shard_, timerId_, startTime);
+		}
+
+		bool TimerHandle::ChangeInterval(const chrono::system_clock::duration& recurringInterval)
+		{
+			return IsValid() && pScheduler_->ChangeTimerInterval(shard_, timerId_, recurringInterval);
+		}
+
+		bool TimerHandle::IsValid() const
+		{
+			return pScheduler_ != nullptr && timerId_ != InvalidTimerId;
+		}
+
+		TimerHandle::operator bool() const
+		{
+			return IsValid();
+		}
+
+		TimerId TimerHandle::GetTimerId() const
+		{
+			return timerId_;
+		}
+
+		Scheduler::Scheduler(std::shared_ptr<ThreadPool> pThreadPool, const std::chrono::system_clock::duration& minRecurringInterval, const unsigned int& maxTaskSize, const std::chrono::system_clock::duration& maxDelayTolerance,
+			const TimerQueueKind& timerQueueKind, const std::chrono::system_clock::duration& timerResolution, const unsigned int& shardCount,
+			const TimerPrecision& timerPrecision)
+			:timerQueueKind_(timerQueueKind),
+			timerPrecision_(timerPrecision),
 			pThreadPool_(pThreadPool),
+			stop_(false),
+			skippedTaskCount_(0),
+			wakeupCount_(0),
+			metricsResetTime_(chrono::steady_clock::now().time_since_epoch().count()),
+			metricsResetWakeupCount_(0),
 			maxTaskSize_(maxTaskSize),
-			ready_(false),
+			maxShardTaskSize_(maxTaskSize / max(shardCount, 1u)),
 			minRecurringInterval_(minRecurringInterval),
 			maxDelayTolerance_(maxDelayTolerance)
 		{
+			for (unsigned int i = 0; i < max(shardCount, 1u); i++)
+			{
+				auto pShard = make_shared<Shard>();
+				if (timerQueueKind_ == TimingWheelQueue)
+				{
+					pShard->pTimerQueue_ = make_shared<TimingWheel>(timerResolution);
+				}
+				else
+				{
+					pShard->pTimerQueue_ = make_shared<TimerHeap>();
+				}
+				shards_.push_back(pShard);
+			}
+
 			Setup();
 		}
 
@@ -26,7 +157,7 @@ namespace utils
 
 		void Scheduler::Setup()
 		{
-			if (pEnqueueThread_)
+			if (shards_.front()->pEnqueueThread_)
 			{
 				//Already created
 				return;
@@ -39,78 +170,212 @@ namespace utils
 				return;
 			}
 
-			pEnqueueThread_ = make_shared<thread>([this]()
+			for (auto& pShard : shards_)
+			{
+				auto pRunShard = pShard.get();
+				pShard->pEnqueueThread_ = make_shared<thread>([this, pRunShard]()
+				{
+					RunShard(*pRunShard);
+				});
+			}
+
+			for (auto& pShard : shards_)
+			{
+				while (!pShard->ready_.load())
+				{
+					this_thread::sleep_for(chrono::microseconds(200));
+				}
+			}
+		}
+
+		void Scheduler::RunShard(Shard& shard)
+		{
+			vector<TimeAndIntervalAndTask> dueTasks;
+			//Due tasks not handed to the pool yet with their timer ids, from pendingHead on. They are handed over in batches after the timers are popped,
+			//and those the pool refuses stay here for the next round. A one-shot timer keeps its id until its task is handed over, so that Cancel still reaches it.
+			vector<pair<shared_ptr<Task>, TimerId>> pendingTasks;
+			size_t pendingHead = 0;
+			vector<shared_ptr<Task>> batch;
+			vector<TimerId> batchTimerIds;
+			smart_handle hTimer(timerPrecision_ == HighTimerPrecision ? CreatePreciseTimer() : nullptr);
+			while (!stop_.load())
 			{
-				while (!stop_.load())
+				wakeupCount_++;
+				auto now = chrono::steady_clock::now();
 				{
-					auto now = std::chrono::system_clock::now();
+					unique_lock<mutex> lock(shard.mtx_);
+					dueTasks.clear();
+					shard.pTimerQueue_->PopDue(now, dueTasks);
+					for (auto& topTimeAndIntvervalAndTask : dueTasks)
 					{
-						unique_lock<mutex> lock(mtx_);
-						while (!tasksQueue_.empty() && tasksQueue_.top().startTime_ <= now)
+						if (topTimeAndIntvervalAndTask.pTask_->IsCancellationRequested())
 						{
-							auto topTimeAndIntvervalAndTask = tasksQueue_.top();
-							shared_ptr<Task> pNextTask;
-							chrono::system_clock::time_point nextStartTime;
-							auto skipCurrentOccurence = false;
-
-							//Set up next occurrence
-							if (topTimeAndIntvervalAndTask.recurringInterval_ != chrono::seconds(0))
-							{		
-								pNextTask = make_shared<Task>(*topTimeAndIntvervalAndTask.pTask_.get());
-								auto passDuration = now - topTimeAndIntvervalAndTask.startTime_;
-								auto remainder = chrono::duration_cast<chrono::milliseconds>(passDuration).count() % chrono::duration_cast<chrono::milliseconds>(topTimeAndIntvervalAndTask.recurringInterval_).count();
-								nextStartTime = now + ((remainder < chrono::duration_cast<chrono::milliseconds>(minRecurringInterval_).count()) ? (topTimeAndIntvervalAndTask.recurringInterval_ + chrono::milliseconds(remainder)) : chrono::milliseconds(remainder));
-
-								//For the recurring task, the default max delay tolerance is 1 second
-								skipCurrentOccurence = passDuration > maxDelayTolerance_;							
-							}
+							//Drop it, and a recurring task is not set up again
+							topTimeAndIntvervalAndTask.pTask_->SetState(Cancelled);
+							shard.pTimerQueue_->Release(topTimeAndIntvervalAndTask.timerId_);
+							skippedTaskCount_++;
+							continue;
+						}
+
+						auto recurring = topTimeAndIntvervalAndTask.recurringInterval_ != chrono::seconds(0);
+						chrono::steady_clock::time_point nextStartTime;
+						auto skipCurrentOccurence = false;
 
-							if (!skipCurrentOccurence)
+						//Set up next occurrence
+						if (recurring)
+						{		
+							//Next slot of the interval grid after now, late occurrences do not shift the ones after them
+							auto passDuration = now - topTimeAndIntvervalAndTask.startTime_;
+							auto interval = chrono::duration_cast<chrono::steady_clock::duration>(topTimeAndIntvervalAndTask.recurringInterval_);
+							nextStartTime = topTimeAndIntvervalAndTask.startTime_ + interval * (passDuration / interval + 1);
+
+							//For the recurring task, the default max delay tolerance is 1 second, counted from the end of the slack
+							auto late = passDuration > maxDelayTolerance_ + topTimeAndIntvervalAndTask.slack_;
+
+							//Every occurrence runs the same task, so one is skipped while the previous one is still queued, waiting for a retry or running.
+							//The state turns Complete before the callback runs, IsRunning covers the callback.
+							auto previousState = topTimeAndIntvervalAndTask.pTask_->GetState();
+							auto overlapping = topTimeAndIntvervalAndTask.occurrenceCount_ > 0 && (previousState == NotStarted || previousState == Running || topTimeAndIntvervalAndTask.pTask_->IsRunning());
+
+							skipCurrentOccurence = late || overlapping;
+							if (skipCurrentOccurence)
 							{
-								if (pThreadPool_->Enqueue(topTimeAndIntvervalAndTask.pTask_))
+								if (late)
 								{
-									tasksQueue_.pop();
-									if (pNextTask)
-									{
-										tasksQueue_.push(TimeAndIntervalAndTask(pNextTask, topTimeAndIntvervalAndTask.recurringInterval_, nextStartTime));
-									}
+									shard.lateSkipCount_++;
 								}
 								else
 								{
-									//Log fail to enqueue
-									this_thread::sleep_for(chrono::microseconds(200));
+									shard.overlapSkipCount_++;
 								}
+
+								shard.skippedByName_[topTimeAndIntvervalAndTask.pTask_->GetNameId()]++;
 							}
-							else
+						}
+
+						if (!skipCurrentOccurence)
+						{
+							if (recurring)
 							{
-								tasksQueue_.pop();
-								if (pNextTask)
-								{
-									tasksQueue_.push(TimeAndIntervalAndTask(pNextTask, topTimeAndIntvervalAndTask.recurringInterval_, nextStartTime));
-								}
+								//Reset the state of the last occurrence, it tells whether this one is still in flight
+								topTimeAndIntvervalAndTask.pTask_->SetState(NotStarted);
 							}
+
+							topTimeAndIntvervalAndTask.occurrenceCount_++;
+							pendingTasks.push_back(make_pair(topTimeAndIntvervalAndTask.pTask_, topTimeAndIntvervalAndTask.timerId_));
+							shard.lateness_.Record(chrono::duration_cast<chrono::nanoseconds>(max(now - topTimeAndIntvervalAndTask.startTime_, chrono::steady_clock::duration(0))).count());
+							shard.firedCount_++;
 						}
 
-						if (tasksQueue_.empty())
+						//Re-arm a recurring timer in place under its id, so that the task's handle still reaches it and nothing is allocated.
+						//A one-shot timer is released once its task is handed over.
+						if (recurring)
 						{
-							if (!ready_.load())
+							topTimeAndIntvervalAndTask.startTime_ = nextStartTime;
+							shard.pTimerQueue_->Rearm(topTimeAndIntvervalAndTask);
+						}
+					}
+				}
+
+				//Never wait for room in the pool, RunTaskAt callers would wait on the lock meanwhile.
+				//A batch is checked against its timers and handed over under the lock, so that Cancel either drops a task or finds it gone to the pool.
+				//A round stops at the first batch the pool does not take whole, so a full pool costs one batch per round whatever the backlog.
+				size_t rejectedCount = 0;
+				while (pendingHead < pendingTasks.size())
+				{
+					unique_lock<mutex> lock(shard.mtx_);
+					batch.clear();
+					batchTimerIds.clear();
+					while (pendingHead < pendingTasks.size() && batch.size() < DispatchBatchSize)
+					{
+						auto& pendingTask = pendingTasks[pendingHead++];
+						auto timerCancelled = !shard.pTimerQueue_->IsLive(pendingTask.second);
+						if (timerCancelled || pendingTask.first->IsCancellationRequested())
+						{
+							pendingTask.first->SetState(Cancelled);
+							shard.pTimerQueue_->Release(pendingTask.second);
+							pendingTask.first = nullptr;
+							if (!timerCancelled)
 							{
-								ready_ = true;
+								skippedTaskCount_++;
 							}
-
-							cdv_.wait(lock);
+							continue;
 						}
-						else
+
+						batch.push_back(move(pendingTask.first));
+						batchTimerIds.push_back(pendingTask.second);
+					}
+
+					auto published = pThreadPool_->TryEnqueueBatch(batch);
+					for (size_t i = 0; i < published; i++)
+					{
+						//A one-shot timer is done, the id of a recurring one is queued again and stays
+						shard.pTimerQueue_->Release(batchTimerIds[i]);
+					}
+
+					if (published < batch.size())
+					{
+						//Log fail to enqueue, put the refused tasks back in order in the slots just emptied, and retry on the next round
+						rejectedCount += batch.size() - published;
+						for (auto i = batch.size(); i > published; i--)
 						{
-							cdv_.wait_until(lock, tasksQueue_.top().startTime_);
+							pendingTasks[--pendingHead] = make_pair(move(batch[i - 1]), batchTimerIds[i - 1]);
 						}
+						break;
 					}
 				}
-			});
 
-			while (!ready_.load())
-			{
-				this_thread::sleep_for(chrono::microseconds(200));
+				if (pendingHead == pendingTasks.size())
+				{
+					pendingTasks.clear();
+					pendingHead = 0;
+				}
+				else if (pendingHead > pendingTasks.size() / 2)
+				{
+					pendingTasks.erase(pendingTasks.begin(), pendingTasks.begin() + pendingHead);
+					pendingHead = 0;
+				}
+
+				{
+					unique_lock<mutex> lock(shard.mtx_);
+					shard.rejectedCount_ += rejectedCount;
+					shard.retryTaskCount_ = pendingTasks.size() - pendingHead;
+					if (stop_.load())
+					{
+						//Stop may have notified while the lock was released for the dispatch, nobody would wake this wait
+						break;
+					}
+
+					if (pendingHead < pendingTasks.size())
+					{
+						//Give the workers 200 microseconds to make room, a new due timer wakes the thread earlier
+						shard.cdv_.wait_until(lock, min(shard.pTimerQueue_->GetNextTime(), chrono::steady_clock::now() + chrono::microseconds(200)));
+					}
+					else if (shard.pTimerQueue_->GetSize() == 0)
+					{
+						if (!shard.ready_.load())
+						{
+							shard.ready_ = true;
+						}
+
+						shard.cdv_.wait(lock);
+					}
+					else if (timerPrecision_ != HighTimerPrecision)
+					{
+						shard.cdv_.wait_until(lock, shard.pTimerQueue_->GetNextTime());
+					}
+					else if (shard.pTimerQueue_->GetNextTime() - chrono::steady_clock::now() > PreciseWaitWindow)
+					{
+						shard.cdv_.wait_until(lock, shard.pTimerQueue_->GetNextTime() - PreciseWaitWindow);
+					}
+					else
+					{
+						//Tasks armed meanwhile for an earlier time wait for the end of this one, it is at most PreciseWaitWindow long
+						auto nextTime = shard.pTimerQueue_->GetNextTime();
+						lock.unlock();
+						WaitPrecisely(hTimer.get(), nextTime);
+					}
+				}
 			}
 		}
 
@@ -124,10 +389,21 @@ namespace utils
 
 			//Stop Equeue Thread
 			stop_ = true;
-			cdv_.notify_all();
-			if (pEnqueueThread_)
+			for (auto& pShard : shards_)
 			{
-				pEnqueueThread_->join();
+				{
+					//Under the lock, so that a thread between its stop check and its wait does not miss the notification
+					lock_guard<mutex> lock(pShard->mtx_);
+				}
+				pShard->cdv_.notify_all();
+			}
+
+			for (auto& pShard : shards_)
+			{
+				if (pShard->pEnqueueThread_)
+				{
+					pShard->pEnqueueThread_->join();
+				}
 			}
 
 			//Stop ThreadPool
@@ -137,53 +413,206 @@ namespace utils
 			}
 		}
 
-		bool Scheduler::RunRecurringTaskAt(const std::chrono::system_clock::time_point& startTime, std::chrono::system_clock::duration recurringInterval, std::shared_ptr<Task> pTask)
+		TimerHandle Scheduler::RunRecurringTaskAt(const std::chrono::system_clock::time_point& startTime, std::chrono::system_clock::duration recurringInterval, std::shared_ptr<Task> pTask, const size_t& shardKey,
+			const std::chrono::system_clock::duration& slack)
 		{
 			if (!pTask)
 			{
 				//Log
-				return false;
+				return TimerHandle();
 			}
 
 			if (recurringInterval != chrono::seconds(0) && recurringInterval < minRecurringInterval_)
 			{
 				//Log
-				return false;
+				return TimerHandle();
 			}
 
 			// 100 years ago schedule task is not valid
 			if ((chrono::system_clock::now() - startTime) > chrono::hours(100 * 365 * 24))
 			{
 				//Log
-				return false;
+				return TimerHandle();
 			}
 
+			auto shard = GetShardIndex(shardKey);
+			auto& pShard = shards_[shard];
+			TimerId timerId;
 			{
-				unique_lock<mutex> lock(mtx_);
-				if (tasksQueue_.size() > maxTaskSize_)
+				unique_lock<mutex> lock(pShard->mtx_);
+				if (pShard->pTimerQueue_->GetSize() > maxShardTaskSize_)
 				{
 					//Log reach the max task size
+					return TimerHandle();
+				}
+
+				TimeAndIntervalAndTask timeAndRepeatIntervalAndTask(pTask, recurringInterval, ToSteadyTime(startTime), InvalidTimerId, 0, max(chrono::duration_cast<chrono::steady_clock::duration>(slack), chrono::steady_clock::duration(0)));
+
+				timerId = pShard->pTimerQueue_->Push(timeAndRepeatIntervalAndTask);
+			}
+
+			pShard->cdv_.notify_one();
+
+			return TimerHandle(this, shard, timerId);
+		}	
+
+		unsigned int Scheduler::GetShardIndex(const size_t& shardKey) const
+		{
+			return static_cast<unsigned int>((shardKey == AnyShard ? threadShard : shardKey) % shards_.size());
+		}
+
+		bool Scheduler::CancelTimer(const unsigned int& shard, const TimerId& timerId)
+		{
+			auto& pShard = shards_[shard];
+			shared_ptr<Task> pTask;
+			{
+				unique_lock<mutex> lock(pShard->mtx_);
+				auto timer = pShard->pTimerQueue_->Cancel(timerId);
+				if (!timer.pTask_)
+				{
 					return false;
 				}
 
-				TimeAndIntervalAndTask timeAndRepeatIntervalAndTask(pTask, recurringInterval, startTime);
+				//A task that already ran keeps the state of its last occurrence
+				if (timer.occurrenceCount_ == 0)
+				{
+					pTask = timer.pTask_;
+				}
+			}
 
-				tasksQueue_.push(timeAndRepeatIntervalAndTask);
+			if (pTask)
+			{
+				pTask->SetState(Cancelled);
 			}
 
-			cdv_.notify_one();
+			return true;
+		}
 
+		bool Scheduler::RescheduleTimer(const unsigned int& shard, const TimerId& timerId, const chrono::system_clock::time_point& startTime)
+		{
+			auto& pShard = shards_[shard];
+			{
+				unique_lock<mutex> lock(pShard->mtx_);
+				if (!pShard->pTimerQueue_->Reschedule(timerId, ToSteadyTime(startTime)))
+				{
+					return false;
+				}
+			}
+
+			//The enqueue thread may wait for a later time
+			pShard->cdv_.notify_one();
 			return true;
-		}	
+		}
+
+		bool Scheduler::ChangeTimerInterval(const unsigned int& shard, const TimerId& timerId, const chrono::system_clock::duration& recurringInterval)
+		{
+			if (recurringInterval != chrono::seconds(0) && recurringInterval < minRecurringInterval_)
+			{
+				//Log
+				return false;
+			}
+
+			auto& pShard = shards_[shard];
+			unique_lock<mutex> lock(pShard->mtx_);
+			return pShard->pTimerQueue_->ChangeInterval(timerId, recurringInterval);
+		}
 
-		bool Scheduler::RunTaskAt(std::chrono::system_clock::time_point startTime, std::shared_ptr<Task> pTask)
+		unsigned long long Scheduler::GetSkippedTaskCount() const
+		{
+			return skippedTaskCount_.load();
+		}
+
+		unsigned long long Scheduler::GetWakeupCount() const
+		{
+			return wakeupCount_.load();
+		}
+
+		TimerQueueKind Scheduler::GetTimerQueueKind() const
+		{
+			return timerQueueKind_;
+		}
+
+		TimerPrecision Scheduler::GetTimerPrecision() const
+		{
+			return timerPrecision_;
+		}
+
+		unsigned int Scheduler::GetShardCount() const
+		{
+			return static_cast<unsigned int>(shards_.size());
+		}
+
+		size_t Scheduler::GetPendingTaskCount()
+		{
+			size_t count = 0;
+			for (auto& pShard : shards_)
+			{
+				unique_lock<mutex> lock(pShard->mtx_);
+				count += pShard->pTimerQueue_->GetSize();
+			}
+
+			return count;
+		}
+
+		SchedulerMetrics Scheduler::GetMetrics()
+		{
+			SchedulerMetrics metrics;
+			unordered_map<unsigned int, unsigned long long> skippedByName;
+			for (auto& pShard : shards_)
+			{
+				unique_lock<mutex> lock(pShard->mtx_);
+				LatencySnapshot lateness;
+				pShard->lateness_.CopyTo(lateness);
+				metrics.lateness_.Add(lateness);
+				metrics.firedCount_ += pShard->firedCount_;
+				metrics.lateSkipCount_ += pShard->lateSkipCount_;
+				metrics.overlapSkipCount_ += pShard->overlapSkipCount_;
+				metrics.rejectedCount_ += pShard->rejectedCount_;
+				metrics.pendingTaskCount_ += pShard->pTimerQueue_->GetSize();
+				metrics.retryTaskCount_ += pShard->retryTaskCount_;
+				for (auto& skipped : pShard->skippedByName_)
+				{
+					skippedByName[skipped.first] += skipped.second;
+				}
+			}
+
+			for (auto& skipped : skippedByName)
+			{
+				metrics.skippedByName_[Task::GetNameById(skipped.first)] += skipped.second;
+			}
+
+			metrics.wakeupCount_ = wakeupCount_.load() - metricsResetWakeupCount_.load();
+			auto elapsed = chrono::steady_clock::now() - chrono::steady_clock::time_point(chrono::steady_clock::duration(metricsResetTime_.load()));
+			auto seconds = chrono::duration<double>(elapsed).count();
+			metrics.wakeupsPerSecond_ = seconds > 0 ? metrics.wakeupCount_ / seconds : 0;
+			return metrics;
+		}
+
+		void Scheduler::ResetMetrics()
+		{
+			metricsResetTime_ = chrono::steady_clock::now().time_since_epoch().count();
+			metricsResetWakeupCount_ = wakeupCount_.load();
+			for (auto& pShard : shards_)
+			{
+				//The enqueue thread only records under the lock, so the histogram can be cleared here
+				unique_lock<mutex> lock(pShard->mtx_);
+				pShard->lateness_.Clear();
+				pShard->firedCount_ = 0;
+				pShard->lateSkipCount_ = 0;
+				pShard->overlapSkipCount_ = 0;
+				pShard->rejectedCount_ = 0;
+				pShard->skippedByName_.clear();
+			}
+		}
+
+		TimerHandle Scheduler::RunTaskAt(std::chrono::system_clock::time_point startTime, std::shared_ptr<Task> pTask, const size_t& shardKey, const std::chrono::system_clock::duration& slack)
 		{
 			if (startTime < (chrono::system_clock::now() - maxDelayTolerance_))
 			{
 				//Log the none-recurring task start time is in the pass, the task should be schduled from now on
-				return false;
+				return TimerHandle();
 			}
-			return RunRecurringTaskAt(startTime, chrono::seconds(0), pTask);
+			return RunRecurringTaskAt(startTime, chrono::seconds(0), pTask, shardKey, slack);
 		}
 	}
 }
\ No newline at end of file
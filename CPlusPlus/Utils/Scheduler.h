@@ -1,53 +1,191 @@
 #pragma once
 #include "Task.h"
 #include "ThreadPool.h"
+#include "TimerQueue.h"
 namespace utils
 {
 	namespace thread_management
 	{
-		struct TimeAndIntervalAndTask
+#ifdef __cpp_impl_coroutine
+		class SleepAwaiter;
+#endif
+		class Scheduler;
+
+		enum TimerPrecision
 		{
-			TimeAndIntervalAndTask(std::shared_ptr<Task> pTask, const std::chrono::system_clock::duration& recurringInterval, const std::chrono::system_clock::time_point& startTime)
-				: pTask_(pTask),
-				recurringInterval_(recurringInterval),
-				startTime_(startTime)
-			{}		
-
-			std::shared_ptr<Task> pTask_;
-			std::chrono::system_clock::duration recurringInterval_;
-			std::chrono::system_clock::time_point startTime_;			
+			//Wait on the shard's condition variable until the due time, tasks start late by the system's wakeup slop
+			CoarseTimerPrecision,
+			//Sleep on a high resolution waitable timer until shortly before the due time and spin the rest of the way, at the cost of some CPU per occurrence
+			HighTimerPrecision
 		};
 
-		struct TimeAndIntervalAndTaskSorter
+		//Shard key that lets the Scheduler pick the shard of the calling thread
+		const size_t AnyShard = static_cast<size_t>(-1);
+
+		//Handle of a task given to a Scheduler, to cancel or move it until it fires. Copies refer to the same timer.
+		//A recurring task keeps its handle across occurrences. Use it only while the Scheduler lives.
+		class TimerHandle
 		{
-			bool operator()(const TimeAndIntervalAndTask& left, const TimeAndIntervalAndTask& right)
-			{
-				return left.startTime_ > right.startTime_;
-			}
-		};		
+		public:
+			//Refers to no timer, as returned when the Scheduler refuses a task
+			TimerHandle();
+
+			//Drop the timer, its task never reaches the pool again. The state of a task that never ran becomes Cancelled.
+			//A due occurrence still waiting for room in the pool is dropped too. Return false if there is nothing left to cancel: the task already reached the pool.
+			bool Cancel();
+			//Move the next occurrence to startTime. Return false if the timer is not pending any more.
+			bool Reschedule(const std::chrono::system_clock::time_point& startTime);
+			//Interval of the occurrences after the next one, 0 stops a recurring timer after it. Return false if the timer is not pending any more or the interval is below the Scheduler's minimum.
+			bool ChangeInterval(const std::chrono::system_clock::duration& recurringInterval);
+
+			//The Scheduler accepted the task
+			bool IsValid() const;
+			explicit operator bool() const;
+			TimerId GetTimerId() const;
 
+		private:
+			friend class Scheduler;
+
+			TimerHandle(Scheduler* pScheduler, const unsigned int& shard, const TimerId& timerId);
+
+			Scheduler* pScheduler_;
+			unsigned int shard_;
+			TimerId timerId_;
+		};
+
+		//Copy of a Scheduler's metrics since its last ResetMetrics, summed over its shards.
+		struct SchedulerMetrics
+		{
+			SchedulerMetrics()
+				: firedCount_(0),
+				lateSkipCount_(0),
+				overlapSkipCount_(0),
+				rejectedCount_(0),
+				pendingTaskCount_(0),
+				retryTaskCount_(0),
+				wakeupCount_(0),
+				wakeupsPerSecond_(0)
+			{}
+
+			//Time from the start time of every occurrence handed over to the pool to when it was found due, slack included
+			LatencySnapshot lateness_;
+			unsigned long long firedCount_;
+			//Recurring occurrences skipped for being later than maxDelayTolerance, and for coming while the previous one was still queued or running
+			unsigned long long lateSkipCount_;
+			unsigned long long overlapSkipCount_;
+			//Skipped occurrences of both kinds per task name, tasks without a name count under ""
+			std::unordered_map<std::string, unsigned long long> skippedByName_;
+			//Due tasks the pool refused, a task refused on several rounds counts every time
+			unsigned long long rejectedCount_;
+			//Timers waiting for their time, and due tasks waiting for room in the pool, at the time of the copy
+			size_t pendingTaskCount_;
+			size_t retryTaskCount_;
+			//Wakeups of the enqueue threads, and per second since the last ResetMetrics
+			unsigned long long wakeupCount_;
+			double wakeupsPerSecond_;
+		};
+
+		//Start times are converted to the steady clock when a task is armed or rescheduled: a step of the wall clock afterwards (NTP, manual change) does not move them.
 		class Scheduler
 		{
 		public:
-			Scheduler(std::shared_ptr<ThreadPool> pThreadPool, const std::chrono::system_clock::duration& minRecurringInterval = std::chrono::milliseconds(100), const unsigned int& maxTaskSize = 1000000, const std::chrono::system_clock::duration& maxDelayTolerance_ = std::chrono::milliseconds(1000));
+			//timerQueueKind picks how the pending tasks are kept, see TimerQueue.h. A TimingWheel rounds start times up to timerResolution.
+			//shardCount splits the tasks over independent shards, each with its own lock, timer queue and enqueue thread, all feeding pThreadPool.
+			//maxTaskSize is shared evenly between the shards.
+			//timerPrecision picks how the enqueue threads wait for the next due time, see TimerPrecision.
+			Scheduler(std::shared_ptr<ThreadPool> pThreadPool, const std::chrono::system_clock::duration& minRecurringInterval = std::chrono::milliseconds(100), const unsigned int& maxTaskSize = 1000000, const std::chrono::system_clock::duration& maxDelayTolerance_ = std::chrono::milliseconds(1000),
+				const TimerQueueKind& timerQueueKind = TimerHeapQueue, const std::chrono::system_clock::duration& timerResolution = std::chrono::milliseconds(1), const unsigned int& shardCount = 1,
+				const TimerPrecision& timerPrecision = CoarseTimerPrecision);
 			~Scheduler();
 
-			bool RunTaskAt(std::chrono::system_clock::time_point startTime, std::shared_ptr<Task> pTask);			
-			bool RunRecurringTaskAt(const std::chrono::system_clock::time_point& startTime, std::chrono::system_clock::duration recurringInterval, std::shared_ptr<Task> pTask);
+			//Return an invalid handle if the task is refused.
+			//Every occurrence of a recurring task runs pTask itself, which holds the state and times of the last one.
+			//An occurrence due while the previous one is still queued or running, its callback included, is skipped.
+			//Tasks with the same shardKey go to the same shard. With AnyShard each calling thread sticks to one shard, threads are spread round robin.
+			//slack lets every occurrence start up to that much after its time, so that timers of different phases expire together and the shard wakes up once for all of them.
+			TimerHandle RunTaskAt(std::chrono::system_clock::time_point startTime, std::shared_ptr<Task> pTask, const size_t& shardKey = AnyShard,
+				const std::chrono::system_clock::duration& slack = std::chrono::system_clock::duration(0));
+			TimerHandle RunRecurringTaskAt(const std::chrono::system_clock::time_point& startTime, std::chrono::system_clock::duration recurringInterval, std::shared_ptr<Task> pTask, const size_t& shardKey = AnyShard,
+				const std::chrono::system_clock::duration& slack = std::chrono::system_clock::duration(0));
+
+#ifdef __cpp_impl_coroutine
+			//co_await scheduler.SleepFor(duration) resumes the coroutine on the pool once the time is reached, see Coroutine.h.
+			SleepAwaiter SleepFor(const std::chrono::system_clock::duration& duration);
+			SleepAwaiter SleepUntil(const std::chrono::system_clock::time_point& time);
+#endif
+
+			//Tasks cancelled through their token before they were due, a cancelled recurring task is dropped with all its next occurrences.
+			unsigned long long GetSkippedTaskCount() const;
+			//Times the enqueue threads of all the shards woke up, to check what slack saves. Never reset, GetMetrics reports the wakeups since the last ResetMetrics.
+			unsigned long long GetWakeupCount() const;
+			TimerQueueKind GetTimerQueueKind() const;
+			TimerPrecision GetTimerPrecision() const;
+			unsigned int GetShardCount() const;
+			//Pending tasks of all the shards
+			size_t GetPendingTaskCount();
+			//Copy the metrics of the shards one at a time under their lock, it holds each lock about as long as arming a task.
+			SchedulerMetrics GetMetrics();
+			//Start the metrics over
+			void ResetMetrics();
 
 		private:
+			friend class TimerHandle;
+
+			//Due tasks handed to the pool at once
+			static const size_t DispatchBatchSize = 1024;
+
+			//One timer queue with the lock guarding it and the thread enqueuing its due tasks
+			struct Shard
+			{
+				Shard()
+					: ready_(false),
+					firedCount_(0),
+					lateSkipCount_(0),
+					overlapSkipCount_(0),
+					rejectedCount_(0),
+					retryTaskCount_(0)
+				{}
+
+				std::shared_ptr<TimerQueue> pTimerQueue_;
+				std::shared_ptr<std::thread> pEnqueueThread_;
+				std::atomic<bool> ready_;
+				std::mutex mtx_;
+				std::condition_variable cdv_;
+
+				//Metrics since the last ResetMetrics, guarded by mtx_ like the queue, see SchedulerMetrics
+				LatencyHistogram lateness_;
+				unsigned long long firedCount_;
+				unsigned long long lateSkipCount_;
+				unsigned long long overlapSkipCount_;
+				unsigned long long rejectedCount_;
+				size_t retryTaskCount_;
+				//Skipped occurrences per task name id
+				std::unordered_map<unsigned int, unsigned long long> skippedByName_;
+			};
+
 			void Setup();
 			void Stop();
+			//Body of a shard's enqueue thread
+			void RunShard(Shard& shard);
+			unsigned int GetShardIndex(const size_t& shardKey) const;
+			bool CancelTimer(const unsigned int& shard, const TimerId& timerId);
+			bool RescheduleTimer(const unsigned int& shard, const TimerId& timerId, const std::chrono::system_clock::time_point& startTime);
+			bool ChangeTimerInterval(const unsigned int& shard, const TimerId& timerId, const std::chrono::system_clock::duration& recurringInterval);
 
-			std::priority_queue<TimeAndIntervalAndTask, std::vector<TimeAndIntervalAndTask>, TimeAndIntervalAndTaskSorter> tasksQueue_;
+			TimerQueueKind timerQueueKind_;
+			TimerPrecision timerPrecision_;
+			std::vector<std::shared_ptr<Shard>> shards_;
 			std::shared_ptr<ThreadPool> pThreadPool_;
-			std::shared_ptr<std::thread> pEnqueueThread_;
 			std::atomic<bool> stop_;
-			std::atomic<bool> ready_;
+			std::atomic<unsigned long long> skippedTaskCount_;
+			std::atomic<unsigned long long> wakeupCount_;
+			//Steady clock ticks and wakeupCount_ at the last ResetMetrics, the metrics count the wakeups since then
+			std::atomic<std::chrono::steady_clock::rep> metricsResetTime_;
+			std::atomic<unsigned long long> metricsResetWakeupCount_;
 
-			std::mutex mtx_;
-			std::condition_variable cdv_;
 			unsigned int maxTaskSize_;
+			//maxTaskSize_ split between the shards
+			unsigned int maxShardTaskSize_;
 			std::chrono::system_clock::duration minRecurringInterval_;
 			std::chrono::system_clock::duration maxDelayTolerance_;
 		};
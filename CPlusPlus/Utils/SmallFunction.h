@@ -0,0 +1,174 @@
+#pragma once
+
+namespace utils
+{
+	namespace thread_management
+	{
+		//Move-only, type-erased void() callable.
+		//Callables up to InlineSize bytes are stored in place, larger ones fall back to the heap.
+		class SmallFunction
+		{
+		public:
+			static const size_t InlineSize = 64;
+
+			SmallFunction()
+				: pOperations_(nullptr)
+			{
+			}
+
+			template <typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, SmallFunction>::value>::type>
+			SmallFunction(F&& function)
+				: pOperations_(nullptr)
+			{
+				typedef typename std::decay<F>::type Function;
+				Store<Function>(std::forward<F>(function), std::integral_constant<bool, FitsInline<Function>::value>());
+			}
+
+			SmallFunction(SmallFunction&& rhs)
+				: pOperations_(nullptr)
+			{
+				MoveFrom(rhs);
+			}
+
+			SmallFunction& operator=(SmallFunction&& rhs)
+			{
+				if (this != &rhs)
+				{
+					Reset();
+					MoveFrom(rhs);
+				}
+
+				return *this;
+			}
+
+			~SmallFunction()
+			{
+				Reset();
+			}
+
+			SmallFunction(const SmallFunction& rhs) = delete;
+			SmallFunction& operator=(const SmallFunction& rhs) = delete;
+
+			void operator()()
+			{
+				pOperations_->invoke(&storage_);
+			}
+
+			explicit operator bool() const
+			{
+				return pOperations_ != nullptr;
+			}
+
+			//True when the callable lives in the inline buffer, i.e. constructing the SmallFunction did not allocate.
+			bool IsInline() const
+			{
+				return pOperations_ != nullptr && pOperations_->inline_;
+			}
+
+			void Reset()
+			{
+				if (pOperations_)
+				{
+					pOperations_->destroy(&storage_);
+					pOperations_ = nullptr;
+				}
+			}
+
+		private:
+			typedef std::aligned_storage<InlineSize>::type Storage;
+
+			struct Operations
+			{
+				void(*invoke)(void* pStorage);
+				//Move construct into pDestination and destroy the source
+				void(*relocate)(void* pDestination, void* pSource);
+				void(*destroy)(void* pStorage);
+				bool inline_;
+			};
+
+			template <typename Function>
+			struct FitsInline
+			{
+				static const bool value = sizeof(Function) <= InlineSize && std::alignment_of<Storage>::value % std::alignment_of<Function>::value == 0;
+			};
+
+			template <typename Function>
+			struct InlineOperations
+			{
+				static void Invoke(void* pStorage)
+				{
+					(*static_cast<Function*>(pStorage))();
+				}
+
+				static void Relocate(void* pDestination, void* pSource)
+				{
+					new (pDestination) Function(std::move(*static_cast<Function*>(pSource)));
+					static_cast<Function*>(pSource)->~Function();
+				}
+
+				static void Destroy(void* pStorage)
+				{
+					static_cast<Function*>(pStorage)->~Function();
+				}
+
+				static const Operations* Get()
+				{
+					static const Operations operations = { &Invoke, &Relocate, &Destroy, true };
+					return &operations;
+				}
+			};
+
+			template <typename Function>
+			struct HeapOperations
+			{
+				static void Invoke(void* pStorage)
+				{
+					(**static_cast<Function**>(pStorage))();
+				}
+
+				static void Relocate(void* pDestination, void* pSource)
+				{
+					*static_cast<Function**>(pDestination) = *static_cast<Function**>(pSource);
+				}
+
+				static void Destroy(void* pStorage)
+				{
+					delete *static_cast<Function**>(pStorage);
+				}
+
+				static const Operations* Get()
+				{
+					static const Operations operations = { &Invoke, &Relocate, &Destroy, false };
+					return &operations;
+				}
+			};
+
+			template <typename Function, typename F>
+			void Store(F&& function, std::true_type)
+			{
+				new (&storage_) Function(std::forward<F>(function));
+				pOperations_ = InlineOperations<Function>::Get();
+			}
+
+			template <typename Function, typename F>
+			void Store(F&& function, std::false_type)
+			{
+				*reinterpret_cast<Function**>(&storage_) = new Function(std::forward<F>(function));
+				pOperations_ = HeapOperations<Function>::Get();
+			}
+
+			void MoveFrom(SmallFunction& rhs)
+			{
+				if (rhs.pOperations_)
+				{
+					rhs.pOperations_->relocate(&storage_, &rhs.storage_);
+					pOperations_ = rhs.pOperations_;
+					rhs.pOperations_ = nullptr;
+				}
+			}
+
+			Storage storage_;
+			const Operations* pOperations_;
+		};
+	}
+}
\ No newline at end of file
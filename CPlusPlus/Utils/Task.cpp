@@ -9,19 +9,39 @@ namespace utils
 {
 	namespace thread_management
 	{
+		namespace
+		{
+			//Names beyond this are not interned and get id 0, so that per task unique names cannot grow the table without bound.
+			const size_t MaxTaskNameCount = 65536;
+
+			utils::SlimReadWriteLock taskNamesLock;
+			unordered_map<string, unsigned int> taskNameIds;
+			vector<string> taskNames(1);
+		}
+
 		Task::Task
 			(
 			std::function<void()> action,		
 			const string& name,
 			const string& guid,
-			std::function<void()> callback
+			std::function<void()> callback,
+			const TaskPriority& priority
 			)
 			:
-			action_(action),			
 			name_(name),
 			guid_(guid),
+			action_(action),
+			callback_(callback),
+			deadline_(chrono::steady_clock::time_point::max()),
+			startTime_(0),
+			completeTime_(0),
+			enqueueTime_(0),
+			nameId_(RegisterName(name)),
 			state_(NotStarted),
-			callback_(callback)
+			priority_(priority),
+			hasErrorMessage_(false),
+			running_(false),
+			blocking_(false)
 		{
 			InitializeSRWLock(&srwLock_);
 		}
@@ -30,12 +50,20 @@ namespace utils
 			:
 			name_(rhs.name_),
 			guid_(rhs.guid_),
-			startTime_(rhs.startTime_),
-			completeTime_(rhs.completeTime_),
-			errorMessage_(rhs.errorMessage_),
-			state_(rhs.state_),
+			errorMessage_(rhs.GetErrorMessage()),
 			action_(rhs.action_),
-			callback_(rhs.callback_)
+			callback_(rhs.callback_),
+			cancellationToken_(rhs.cancellationToken_),
+			deadline_(rhs.deadline_),
+			startTime_(rhs.startTime_.load()),
+			completeTime_(rhs.completeTime_.load()),
+			enqueueTime_(rhs.enqueueTime_.load()),
+			nameId_(rhs.nameId_),
+			state_(rhs.state_.load()),
+			priority_(rhs.priority_.load()),
+			hasErrorMessage_(!errorMessage_.empty()),
+			running_(false),
+			blocking_(rhs.blocking_)
 		{
 			InitializeSRWLock(&srwLock_);
 		}
@@ -47,11 +75,17 @@ namespace utils
 		Task& Task::operator = (const Task& rhs)
 		{
 			this->name_ = rhs.name_;
+			this->nameId_ = rhs.nameId_;
 			this->guid_ = rhs.guid_;
-			this->startTime_ = rhs.startTime_;
-			this->completeTime_ = rhs.completeTime_;
-			this->errorMessage_ = rhs.errorMessage_;
-			this->state_ = rhs.state_;
+			this->startTime_.store(rhs.startTime_.load());
+			this->completeTime_.store(rhs.completeTime_.load());
+			this->SetErrorMessage(rhs.GetErrorMessage());
+			this->state_.store(rhs.state_.load());
+			this->priority_.store(rhs.priority_.load());
+			this->enqueueTime_.store(rhs.enqueueTime_.load());
+			this->cancellationToken_ = rhs.cancellationToken_;
+			this->blocking_ = rhs.blocking_;
+			this->deadline_ = rhs.deadline_;
 			this->action_ = rhs.action_;
 			this->callback_ = rhs.callback_;
 			return *this;
@@ -59,23 +93,32 @@ namespace utils
 
 		void Task::Run()
 		{
-			unique_lock<mutex> lock(mutex_);
+			if (IsCancellationRequested())
+			{
+				SetState(Cancelled);
+				return;
+			}
+
+			running_.store(true, memory_order_release);
 			try
 			{
-				startTime_ = chrono::system_clock::now();
+				//Each time is stored before the state that publishes it
+				startTime_.store(chrono::system_clock::now().time_since_epoch().count(), memory_order_relaxed);
 				SetState(Running);
 				if (action_)
 				{
 					action_();
 				}
 
+				completeTime_.store(chrono::system_clock::now().time_since_epoch().count(), memory_order_relaxed);
 				SetState(Complete);
-				completeTime_ = chrono::system_clock::now();
 				//log task excueted
 				if (callback_)
 				{
 					callback_();
 				}
+
+				running_.store(false, memory_order_release);
 			}
 			catch (exception& ex)
 			{
@@ -93,6 +136,7 @@ namespace utils
 				errorMessage.append(ex.what());
 
 				SetErrorMessage(errorMessage);
+				running_.store(false, memory_order_release);
 
 				throw;
 			}
@@ -112,6 +156,7 @@ namespace utils
 				errorMessage.append("Unknown Error");
 
 				SetErrorMessage(errorMessage);
+				running_.store(false, memory_order_release);
 
 				throw;
 			}
@@ -121,42 +166,156 @@ namespace utils
 		{
 			utils::WriteLock lock(srwLock_);
 			errorMessage_ = message;
+			hasErrorMessage_.store(!message.empty(), memory_order_release);
 		}
 
 		std::string Task::GetErrorMessage() const
 		{
+			//Most tasks never fail, their readers do not take the lock
+			if (!hasErrorMessage_.load(memory_order_acquire))
+			{
+				return string();
+			}
+
 			utils::ReadLock lock(srwLock_);
 			return errorMessage_;
 		}
 
 		TaskState Task::GetState() const
 		{
-			utils::ReadLock lock(srwLock_);
-			return state_;
+			return state_.load(memory_order_acquire);
+		}
+
+		bool Task::IsRunning() const
+		{
+			return running_.load(memory_order_acquire);
 		}
 
 		void Task::SetState(const TaskState& state)
 		{
-			utils::WriteLock lock(srwLock_);
-			state_ = state;
+			state_.store(state, memory_order_release);
+		}
+
+		TaskPriority Task::GetPriority() const
+		{
+			return priority_.load(memory_order_relaxed);
+		}
+
+		void Task::SetPriority(const TaskPriority& priority)
+		{
+			priority_.store(priority, memory_order_relaxed);
+		}
+
+		chrono::steady_clock::time_point Task::GetEnqueueTime() const
+		{
+			return chrono::steady_clock::time_point(chrono::steady_clock::duration(enqueueTime_.load(memory_order_relaxed)));
+		}
+
+		void Task::SetEnqueueTime(const chrono::steady_clock::time_point& enqueueTime)
+		{
+			enqueueTime_.store(enqueueTime.time_since_epoch().count(), memory_order_relaxed);
+		}
+
+		CancellationToken Task::GetCancellationToken() const
+		{
+			return cancellationToken_;
+		}
+
+		void Task::SetCancellationToken(const CancellationToken& token)
+		{
+			cancellationToken_ = token;
+		}
+
+		bool Task::IsCancellationRequested() const
+		{
+			return cancellationToken_.IsCancellationRequested();
+		}
+
+		void Task::SetBlocking(const bool& blocking)
+		{
+			blocking_ = blocking;
+		}
+
+		bool Task::IsBlocking() const
+		{
+			return blocking_;
+		}
+
+		void Task::SetDeadline(const chrono::steady_clock::time_point& deadline)
+		{
+			deadline_ = deadline;
+		}
+
+		bool Task::HasDeadline() const
+		{
+			return deadline_ != chrono::steady_clock::time_point::max();
+		}
+
+		chrono::steady_clock::time_point Task::GetDeadline() const
+		{
+			return deadline_;
 		}
 
 		string Task::GetName() const
 		{
-			utils::ReadLock lock(srwLock_);
+			//The name never changes once constructed
 			return name_;
 		}
 
+		unsigned int Task::GetNameId() const
+		{
+			return nameId_;
+		}
+
+		unsigned int Task::RegisterName(const string& name)
+		{
+			if (name.empty())
+			{
+				return 0;
+			}
+
+			{
+				utils::ReadLock lock(taskNamesLock);
+				auto it = taskNameIds.find(name);
+				if (it != taskNameIds.end())
+				{
+					return it->second;
+				}
+			}
+
+			utils::WriteLock lock(taskNamesLock);
+			auto it = taskNameIds.find(name);
+			if (it != taskNameIds.end())
+			{
+				return it->second;
+			}
+
+			if (taskNames.size() >= MaxTaskNameCount)
+			{
+				//Log the name table is full
+				return 0;
+			}
+
+			auto nameId = static_cast<unsigned int>(taskNames.size());
+			taskNames.push_back(name);
+			taskNameIds[name] = nameId;
+			return nameId;
+		}
+
+		string Task::GetNameById(const unsigned int& nameId)
+		{
+			utils::ReadLock lock(taskNamesLock);
+			return nameId < taskNames.size() ? taskNames[nameId] : string();
+		}
+
 		chrono::system_clock::time_point Task::GetStartTime() const
 		{
-			utils::ReadLock lock(srwLock_);
-			return startTime_;
+			return chrono::system_clock::time_point(chrono::system_clock::duration(startTime_.load(memory_order_relaxed)));
 		}
 
 		chrono::system_clock::time_point Task::GetCompleteTime() const
 		{
-			utils::ReadLock lock(srwLock_);
-			return completeTime_;
+			return chrono::system_clock::time_point(chrono::system_clock::duration(completeTime_.load(memory_order_relaxed)));
 		}
 
 		std::function<void()> Task::GetAction() const
@@ -1,4 +1,5 @@
 #pragma once
+#include "Cancellation.h"
 
 namespace utils
 {
@@ -9,7 +10,11 @@ namespace utils
 			NotStarted,
 			Complete,
 			Running,
-			Terminated
+			Terminated,
+			//Cancelled through its token before it started, it never ran
+			Cancelled,
+			//Its deadline passed before it started, the pool shed it without running it
+			Expired
 		};
 
 		const std::string TaskStateStr[] =
@@ -17,20 +22,86 @@ namespace utils
 			"NotStarted",
 			"Complete",
 			"Running",
-			"Terminated"
+			"Terminated",
+			"Cancelled",
+			"Expired"
 		};
 
+		enum TaskErrorCode
+		{
+			NoError,
+			//The action threw a std::exception
+			ActionException,
+			//The action completed but the callback threw a std::exception
+			CallbackException,
+			//Something that is not a std::exception was thrown
+			UnknownException
+		};
+
+		const std::string TaskErrorCodeStr[] =
+		{
+			"NoError",
+			"ActionException",
+			"CallbackException",
+			"UnknownException"
+		};
+
+		//Dispatch lane of a task in the ThreadPool, workers drain the lanes in this order.
+		enum TaskPriority
+		{
+			Critical,
+			Normal,
+			Background
+		};
+
+		const unsigned int TaskPriorityCount = 3;
+
+		const std::string TaskPriorityStr[] =
+		{
+			"Critical",
+			"Normal",
+			"Background"
+		};
+
+		//The state, priority and timestamps are atomics: the thread running the task publishes them with release stores,
+		//so monitoring threads read them wait-free and never contend with the run. Only the error message takes a lock, and only once there is one.
 		class Task
 		{
 		public:			
-			Task(std::function<void()> action, const std::string& name = "", const std::string& guid = "", std::function<void()> pCallback = std::function<void()>());
+			Task(std::function<void()> action, const std::string& name = "", const std::string& guid = "", std::function<void()> pCallback = std::function<void()>(), const TaskPriority& priority = Normal);
 			~Task();
 
 			void SetState(const TaskState& state);
 			void SetErrorMessage(const std::string& message);
+			void SetPriority(const TaskPriority& priority);
+			//Set by the ThreadPool when the task is published, used to measure how long it waited in its lane.
+			void SetEnqueueTime(const std::chrono::steady_clock::time_point& enqueueTime);
+			//Once cancellation is requested the task is skipped by the pool or the scheduler holding it, and Run does nothing.
+			//A pool only skips it when a worker dequeues it, until then it holds its place in the queue, see ThreadPool::GetSkippedTaskCount.
+			//A running action polls the token or registers with it to stop early.
+			//Set the token before handing the task to a pool or scheduler, it is read without a lock.
+			void SetCancellationToken(const CancellationToken& token);
+			//A blocking task (disk, network, locks) runs in a ThreadPool::BlockingRegion, so that the pool compensates for its worker.
+			//Set it before handing the task to a pool.
+			void SetBlocking(const bool& blocking);
+			//Time by which the task should be complete. A pool in EarliestDeadlineFirst mode dispatches the tasks with a deadline first, earliest first,
+			//and every pool counts whether they made it. Set it before handing the task to a pool.
+			void SetDeadline(const std::chrono::steady_clock::time_point& deadline);
 
 			TaskState GetState() const;
+			//Run has not returned yet. The state is Complete as soon as the action is done, this stays set until the callback is done too.
+			bool IsRunning() const;
+			TaskPriority GetPriority() const;
+			std::chrono::steady_clock::time_point GetEnqueueTime() const;
+			CancellationToken GetCancellationToken() const;
+			bool IsCancellationRequested() const;
+			bool IsBlocking() const;
+			bool HasDeadline() const;
+			//time_point::max() when the task has no deadline.
+			std::chrono::steady_clock::time_point GetDeadline() const;
 			std::string GetName() const;
+			//Id of the name in the process wide name table, 0 for the empty name or when the table is full.
+			unsigned int GetNameId() const;
 			//std::string GetGuid() const;
 			//void SetErrorMessage(const std::string& message) const;
 			std::string GetErrorMessage() const;
@@ -38,22 +109,37 @@ namespace utils
 			std::chrono::system_clock::time_point GetCompleteTime() const;
 			std::function<void()> GetAction() const;
 			std::function<void()> GetCallback() const;
+			//Run the action then the callback. Do not run the same task in two threads at once, the pool and the scheduler never do.
 			void Run();
 
 			Task& operator=(const Task& rhs);
 			Task(const Task& rhs);
 
+			//Task names are interned once so that history records can refer to them by id.
+			static unsigned int RegisterName(const std::string& name);
+			static std::string GetNameById(const unsigned int& nameId);
+
 		private:
 			std::string name_;
 			std::string guid_;
-			std::chrono::system_clock::time_point startTime_;
-			std::chrono::system_clock::time_point completeTime_;
 			std::string errorMessage_;
-			TaskState state_;
 			std::function<void()> action_;
 			std::function<void()> callback_;
+			CancellationToken cancellationToken_;
+			std::chrono::steady_clock::time_point deadline_;
+			//Clock ticks, so that they can be read while the task runs
+			std::atomic<std::chrono::system_clock::rep> startTime_;
+			std::atomic<std::chrono::system_clock::rep> completeTime_;
+			std::atomic<std::chrono::steady_clock::rep> enqueueTime_;
+			unsigned int nameId_;
+			std::atomic<TaskState> state_;
+			std::atomic<TaskPriority> priority_;
+			//errorMessage_ is only read under the lock once this is set
+			std::atomic<bool> hasErrorMessage_;
+			//Set before the state of a run is published and cleared after its callback
+			std::atomic<bool> running_;
+			bool blocking_;
 			mutable SRWLOCK srwLock_;
-			mutable std::mutex mutex_;
 		};
 	}
 }
\ No newline at end of file
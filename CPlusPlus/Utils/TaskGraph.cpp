@@ -0,0 +1,340 @@
+#include "stdafx.h"
+#include "TaskGraph.h"
+
+using namespace std;
+
+namespace utils
+{
+	namespace thread_management
+	{
+		TaskGraph::TaskGraph(shared_ptr<ThreadPool> pThreadPool)
+			:
+			pThreadPool_(pThreadPool),
+			running_(false),
+			completedCount_(0),
+			failedCount_(0),
+			cancelledCount_(0),
+			finishedCount_(0)
+		{
+		}
+
+		TaskGraph::~TaskGraph()
+		{
+			Wait();
+		}
+
+		TaskGraph::NodeId TaskGraph::Add(shared_ptr<Task> pTask)
+		{
+			return AddNode(pTask, TaskNode);
+		}
+
+		TaskGraph::NodeId TaskGraph::Add(function<void()> action, const string& name)
+		{
+			return AddNode(make_shared<Task>(action, name), TaskNode);
+		}
+
+		TaskGraph::NodeId TaskGraph::AddNode(shared_ptr<Task> pTask, const NodeKind& kind)
+		{
+			nodes_.push_back(make_shared<GraphNode>(pTask, kind));
+			return nodes_.size() - 1;
+		}
+
+		bool TaskGraph::AddDependency(const NodeId& predecessor, const NodeId& successor)
+		{
+			if (running_.load() || predecessor >= nodes_.size() || successor >= nodes_.size())
+			{
+				return false;
+			}
+
+			nodes_[predecessor]->successors_.push_back(successor);
+			nodes_[successor]->predecessorCount_++;
+			return true;
+		}
+
+		TaskGraph::NodeId TaskGraph::WhenAll(const vector<NodeId>& nodes)
+		{
+			return AddJoin(nodes, AllJoin);
+		}
+
+		TaskGraph::NodeId TaskGraph::WhenAny(const vector<NodeId>& nodes)
+		{
+			return AddJoin(nodes, AnyJoin);
+		}
+
+		TaskGraph::NodeId TaskGraph::AddJoin(const vector<NodeId>& nodes, const NodeKind& kind)
+		{
+			auto join = AddNode(nullptr, kind);
+			for (auto& node : nodes)
+			{
+				AddDependency(node, join);
+			}
+
+			return join;
+		}
+
+		bool TaskGraph::HasCycle() const
+		{
+			//Kahn: a node is reached once all its predecessors are, what is never reached sits on a cycle
+			vector<unsigned int> pendingCounts(nodes_.size());
+			vector<NodeId> ready;
+			for (NodeId i = 0; i < nodes_.size(); i++)
+			{
+				pendingCounts[i] = nodes_[i]->predecessorCount_;
+				if (pendingCounts[i] == 0)
+				{
+					ready.push_back(i);
+				}
+			}
+
+			size_t reached = 0;
+			while (!ready.empty())
+			{
+				auto node = ready.back();
+				ready.pop_back();
+				reached++;
+				for (auto successor : nodes_[node]->successors_)
+				{
+					if (--pendingCounts[successor] == 0)
+					{
+						ready.push_back(successor);
+					}
+				}
+			}
+
+			return reached != nodes_.size();
+		}
+
+		bool TaskGraph::Run()
+		{
+			if (running_.load() || HasCycle())
+			{
+				return false;
+			}
+
+			for (auto& pNode : nodes_)
+			{
+				pNode->pendingCount_.store(pNode->predecessorCount_);
+			}
+
+			running_ = true;
+			if (nodes_.empty())
+			{
+				return true;
+			}
+
+			//Collect the roots first, the graph may finish and be waited for before this loop ends
+			vector<NodeId> roots;
+			for (NodeId i = 0; i < nodes_.size(); i++)
+			{
+				if (nodes_[i]->predecessorCount_ == 0)
+				{
+					roots.push_back(i);
+				}
+			}
+
+			for (auto root : roots)
+			{
+				nodes_[root]->state_.store(NodeRunning);
+				Release(root);
+			}
+
+			return true;
+		}
+
+		bool TaskGraph::Wait()
+		{
+			if (!running_.load())
+			{
+				return nodes_.empty();
+			}
+
+			unique_lock<mutex> lock(mutex_);
+			while (finishedCount_.load() != nodes_.size())
+			{
+				cdv_.wait(lock);
+			}
+
+			return completedCount_.load() == nodes_.size();
+		}
+
+		void TaskGraph::Release(const NodeId& node)
+		{
+			auto& graphNode = *nodes_[node];
+			if (graphNode.kind_ != TaskNode)
+			{
+				Finish(node, NodeComplete);
+				return;
+			}
+
+			if (!pThreadPool_->Post([this, node]() { RunNode(node); }, graphNode.pTask_->GetPriority()))
+			{
+				//The pool is stopped
+				Finish(node, NodeCancelled);
+			}
+		}
+
+		void TaskGraph::RunNode(const NodeId& node)
+		{
+			Finish(node, RunTask(node));
+		}
+
+		TaskNodeState TaskGraph::RunTask(const NodeId& node)
+		{
+			auto state = NodeComplete;
+			auto& pTask = nodes_[node]->pTask_;
+			try
+			{
+				pTask->Run();
+
+				//Run does nothing once the task's token is cancelled
+				if (pTask->GetState() == Cancelled)
+				{
+					state = NodeCancelled;
+				}
+			}
+			catch (...)
+			{
+				//Task::Run keeps the error message in the task
+				state = NodeFailed;
+			}
+
+			return state;
+		}
+
+		void TaskGraph::Finish(NodeId node, TaskNodeState state)
+		{
+			//Joins and cancelled successors are finished by this loop rather than recursively, a deep graph would exhaust the stack otherwise
+			vector<pair<NodeId, TaskNodeState>> decided;
+			//Task successors whose predecessors all completed, not handed to the pool yet
+			vector<NodeId> ready;
+			auto nodeCount = nodes_.size();
+			for (;;)
+			{
+				auto& graphNode = *nodes_[node];
+				auto succeeded = state == NodeComplete;
+				for (auto successor : graphNode.successors_)
+				{
+					auto& next = *nodes_[successor];
+					auto expected = NodePending;
+					if (next.kind_ == AnyJoin)
+					{
+						//The first completed predecessor completes it, the last failed one cancels it if none completed
+						if (succeeded ? next.state_.compare_exchange_strong(expected, NodeRunning) : (--next.pendingCount_ == 0 && next.state_.compare_exchange_strong(expected, NodeCancelled)))
+						{
+							decided.push_back(make_pair(successor, succeeded ? NodeComplete : NodeCancelled));
+						}
+					}
+					else if (!succeeded)
+					{
+						//The first failed predecessor cancels it, the others find it decided
+						if (next.state_.compare_exchange_strong(expected, NodeCancelled))
+						{
+							decided.push_back(make_pair(successor, NodeCancelled));
+						}
+					}
+					else if (--next.pendingCount_ == 0 && next.state_.compare_exchange_strong(expected, NodeRunning))
+					{
+						if (next.kind_ == TaskNode)
+						{
+							ready.push_back(successor);
+						}
+						else
+						{
+							decided.push_back(make_pair(successor, NodeComplete));
+						}
+					}
+				}
+
+				graphNode.state_.store(state);
+				if (state == NodeComplete)
+				{
+					completedCount_++;
+				}
+				else if (state == NodeFailed)
+				{
+					failedCount_++;
+				}
+				else
+				{
+					cancelledCount_++;
+				}
+
+				//Count the node last. Only the last node takes the lock: Wait reads the count under it, so the graph cannot be destroyed before the notification is done.
+				auto finished = finishedCount_.load();
+				while (finished + 1 < nodeCount && !finishedCount_.compare_exchange_weak(finished, finished + 1))
+				{
+				}
+
+				if (finished + 1 == nodeCount)
+				{
+					lock_guard<mutex> lock(mutex_);
+					finishedCount_++;
+					cdv_.notify_all();
+					return;
+				}
+
+				//Post from a worker of a full pool runs the task inline, and its successors' the same way: along a chain that nests once per node.
+				//Try the pool instead, and run a refused successor here so that the chain is walked by this loop.
+				while (decided.empty() && !ready.empty())
+				{
+					auto next = ready.back();
+					ready.pop_back();
+					auto priority = nodes_[next]->pTask_->GetPriority();
+					if (pThreadPool_->TryPost([this, next]() { RunNode(next); }, priority))
+					{
+						continue;
+					}
+
+					if (pThreadPool_->IsCurrentWorker() && !pThreadPool_->IsStopped())
+					{
+						decided.push_back(make_pair(next, RunTask(next)));
+					}
+					else if (!pThreadPool_->Post([this, next]() { RunNode(next); }, priority))
+					{
+						//The pool is stopped
+						decided.push_back(make_pair(next, NodeCancelled));
+					}
+				}
+
+				if (decided.empty())
+				{
+					break;
+				}
+
+				node = decided.back().first;
+				state = decided.back().second;
+				decided.pop_back();
+			}
+		}
+
+		TaskNodeState TaskGraph::GetState(const NodeId& node) const
+		{
+			return node < nodes_.size() ? nodes_[node]->state_.load() : NodeCancelled;
+		}
+
+		shared_ptr<Task> TaskGraph::GetTask(const NodeId& node) const
+		{
+			return node < nodes_.size() ? nodes_[node]->pTask_ : nullptr;
+		}
+
+		size_t TaskGraph::GetNodeCount() const
+		{
+			return nodes_.size();
+		}
+
+		unsigned long long TaskGraph::GetCompletedCount() const
+		{
+			return completedCount_.load();
+		}
+
+		unsigned long long TaskGraph::GetFailedCount() const
+		{
+			return failedCount_.load();
+		}
+
+		unsigned long long TaskGraph::GetCancelledCount() const
+		{
+			return cancelledCount_.load();
+		}
+	}
+}
\ No newline at end of file
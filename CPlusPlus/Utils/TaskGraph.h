@@ -0,0 +1,119 @@
+#pragma once
+#include "Task.h"
+#include "ThreadPool.h"
+
+namespace utils
+{
+	namespace thread_management
+	{
+		enum TaskNodeState
+		{
+			//Waiting for its predecessors
+			NodePending,
+			//Released to the pool, or a join being completed
+			NodeRunning,
+			NodeComplete,
+			//Task::Run threw
+			NodeFailed,
+			//The task's token was cancelled, or a predecessor failed or was cancelled: the node never ran
+			NodeCancelled
+		};
+
+		const std::string TaskNodeStateStr[] =
+		{
+			"NodePending",
+			"NodeRunning",
+			"NodeComplete",
+			"NodeFailed",
+			"NodeCancelled"
+		};
+
+		//Directed acyclic graph of tasks run on a ThreadPool.
+		//A node is released to the pool as soon as its last predecessor completes: every node counts its pending predecessors down with an atomic,
+		//no lock is taken between the predecessor completing and the successor being enqueued.
+		//A node whose task throws fails, and every node depending on it is cancelled instead of run.
+		//Build the graph, then Run it once.
+		class TaskGraph
+		{
+		public:
+			typedef size_t NodeId;
+
+			TaskGraph(std::shared_ptr<ThreadPool> pThreadPool);
+			//Wait for a running graph to finish
+			~TaskGraph();
+
+			NodeId Add(std::shared_ptr<Task> pTask);
+			NodeId Add(std::function<void()> action, const std::string& name = "");
+			//successor only runs once predecessor completed. Return false for an unknown node or once the graph runs.
+			bool AddDependency(const NodeId& predecessor, const NodeId& successor);
+			//Join nodes without a task: WhenAll completes when all of the nodes completed, WhenAny as soon as one of them completed.
+			//WhenAll is cancelled by the first node that fails, WhenAny only when all of them failed.
+			NodeId WhenAll(const std::vector<NodeId>& nodes);
+			NodeId WhenAny(const std::vector<NodeId>& nodes);
+
+			//Release the nodes without predecessors. Return false if the graph already ran or has a cycle, nothing runs then.
+			bool Run();
+			//Wait until every node completed, failed or was cancelled. Return true if all of them completed.
+			bool Wait();
+
+			TaskNodeState GetState(const NodeId& node) const;
+			std::shared_ptr<Task> GetTask(const NodeId& node) const;
+			size_t GetNodeCount() const;
+			unsigned long long GetCompletedCount() const;
+			unsigned long long GetFailedCount() const;
+			unsigned long long GetCancelledCount() const;
+
+			TaskGraph& operator=(const TaskGraph& rhs) = delete;
+			TaskGraph(const TaskGraph& rhs) = delete;
+
+		private:
+			enum NodeKind
+			{
+				TaskNode,
+				AllJoin,
+				AnyJoin
+			};
+
+			struct GraphNode
+			{
+				GraphNode(std::shared_ptr<Task> pTask, const NodeKind& kind)
+					: pTask_(pTask),
+					kind_(kind),
+					predecessorCount_(0),
+					pendingCount_(0),
+					state_(NodePending)
+				{}
+
+				std::shared_ptr<Task> pTask_;
+				NodeKind kind_;
+				std::vector<NodeId> successors_;
+				unsigned int predecessorCount_;
+				//Predecessors not finished yet
+				std::atomic<unsigned int> pendingCount_;
+				std::atomic<TaskNodeState> state_;
+			};
+
+			NodeId AddNode(std::shared_ptr<Task> pTask, const NodeKind& kind);
+			NodeId AddJoin(const std::vector<NodeId>& nodes, const NodeKind& kind);
+			bool HasCycle() const;
+			//Hand a released node to the pool, or finish it right away if it is a join.
+			void Release(const NodeId& node);
+			void RunNode(const NodeId& node);
+			//Run the node's task in the calling thread and return the state it leaves the node in.
+			TaskNodeState RunTask(const NodeId& node);
+			//Record the final state of the node and notify its successors, releasing or cancelling those it decides.
+			//Successors are handed to the pool without blocking: when one of its workers finds it full, the successor runs in this loop instead of nesting.
+			void Finish(NodeId node, TaskNodeState state);
+
+			std::shared_ptr<ThreadPool> pThreadPool_;
+			std::vector<std::shared_ptr<GraphNode>> nodes_;
+			std::atomic<bool> running_;
+			std::atomic<unsigned long long> completedCount_;
+			std::atomic<unsigned long long> failedCount_;
+			std::atomic<unsigned long long> cancelledCount_;
+			std::atomic<size_t> finishedCount_;
+			std::mutex mutex_;
+			std::condition_variable cdv_;
+		};
+	}
+}
\ No newline at end of file
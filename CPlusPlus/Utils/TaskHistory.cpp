@@ -0,0 +1,60 @@
+#include "stdafx.h"
+#include "TaskHistory.h"
+#include "Helper.h"
+
+using namespace std;
+
+namespace utils
+{
+	namespace thread_management
+	{
+		TaskHistory::TaskHistory(const size_t& capacity)
+			:
+			capacity_(capacity),
+			count_(0)
+		{
+			InitializeSRWLock(&srwLock_);
+		}
+
+		TaskHistory::~TaskHistory()
+		{
+		}
+
+		void TaskHistory::Add(const TaskRecord& record)
+		{
+			if (capacity_ == 0)
+			{
+				return;
+			}
+
+			utils::WriteLock lock(srwLock_);
+			if (records_.empty())
+			{
+				records_.resize(capacity_);
+			}
+
+			records_[count_ % records_.size()] = record;
+			count_++;
+		}
+
+		void TaskHistory::CopyTo(vector<TaskRecord>& records) const
+		{
+			utils::ReadLock lock(srwLock_);
+			if (count_ <= records_.size())
+			{
+				records.insert(records.end(), records_.begin(), records_.begin() + static_cast<size_t>(count_));
+				return;
+			}
+
+			auto oldest = static_cast<size_t>(count_ % records_.size());
+			records.insert(records.end(), records_.begin() + oldest, records_.end());
+			records.insert(records.end(), records_.begin(), records_.begin() + oldest);
+		}
+
+		unsigned long long TaskHistory::GetCount() const
+		{
+			utils::ReadLock lock(srwLock_);
+			return count_;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include "Task.h"
+
+namespace utils
+{
+	namespace thread_management
+	{
+		//Compact record of a finished task, it does not keep the task nor its closures alive.
+		struct TaskRecord
+		{
+			unsigned int nameId_;
+			TaskState state_;
+			TaskPriority priority_;
+			TaskErrorCode errorCode_;
+			std::chrono::steady_clock::time_point enqueueTime_;
+			std::chrono::system_clock::time_point startTime_;
+			std::chrono::system_clock::time_point completeTime_;
+		};
+
+		//Fixed size ring of the last records written by one worker.
+		//Only the owning worker writes to it, so its lock is uncontended unless the history is being queried.
+		//The ring is allocated on the first Add, a worker slot that never runs does not cost its capacity.
+		class TaskHistory
+		{
+		public:
+			TaskHistory(const size_t& capacity);
+			~TaskHistory();
+
+			void Add(const TaskRecord& record);
+			//Append the records, oldest first.
+			void CopyTo(std::vector<TaskRecord>& records) const;
+			unsigned long long GetCount() const;
+
+			TaskHistory& operator=(const TaskHistory& rhs) = delete;
+			TaskHistory(const TaskHistory& rhs) = delete;
+
+		private:
+			std::vector<TaskRecord> records_;
+			size_t capacity_;
+			unsigned long long count_;
+			mutable SRWLOCK srwLock_;
+		};
+	}
+}
\ No newline at end of file
@@ -9,19 +9,130 @@ namespace utils
 {
 	namespace thread_management
 	{
-		ThreadPool::ThreadPool(unsigned int poolSize, const wstring& name, const unsigned int& maxQueryableExecutedTaskSize, const unsigned int& maxPendingTaskSize, const int& priority)
+		namespace
+		{
+			//The pool and the worker index the current thread belongs to, used to route tasks enqueued from a running task to the local deque.
+			thread_local ThreadPool* currentPool = nullptr;
+			thread_local unsigned int currentWorkerIndex = 0;
+			//The current thread is in a BlockingRegion
+			thread_local bool currentBlocked = false;
+
+			//Every NormalLaneInterval-th dispatch of a worker looks at the Normal lane first, every BackgroundLaneInterval-th at the Background lane.
+			const unsigned long long NormalLaneInterval = 4;
+			const unsigned long long BackgroundLaneInterval = 16;
+
+			//Only keep 1000 exception tasks
+			const unsigned int MaxQueryableExceptionTaskSize = 1000;
+
+			//An elastic pool grows once a worker dispatched that many tasks in a row that waited longer than the threshold
+			const unsigned int SustainedSlowDispatchCount = 3;
+
+			//Processors of a group are numbered within a KAFFINITY mask
+			const unsigned int GroupProcessorCount = sizeof(KAFFINITY) * 8;
+
+			struct LogicalProcessor
+			{
+				WORD group_;
+				unsigned int number_;
+				unsigned int node_;
+			};
+
+			//NUMA nodes with at least one processor, their processor masks and their processors in node order
+			void GetTopology(vector<unsigned int>& nodes, vector<GROUP_AFFINITY>& nodeAffinities, vector<LogicalProcessor>& processors)
+			{
+				ULONG highestNode = 0;
+				if (!::GetNumaHighestNodeNumber(&highestNode))
+				{
+					highestNode = 0;
+				}
+
+				for (USHORT node = 0; node <= highestNode; node++)
+				{
+					GROUP_AFFINITY affinity;
+					memset(&affinity, 0, sizeof(affinity));
+					if (!::GetNumaNodeProcessorMaskEx(node, &affinity) || affinity.Mask == 0)
+					{
+						continue;
+					}
+
+					for (unsigned int number = 0; number < GroupProcessorCount; number++)
+					{
+						if (affinity.Mask & (static_cast<KAFFINITY>(1) << number))
+						{
+							LogicalProcessor processor;
+							processor.group_ = affinity.Group;
+							processor.number_ = number;
+							processor.node_ = static_cast<unsigned int>(nodes.size());
+							processors.push_back(processor);
+						}
+					}
+
+					nodes.push_back(node);
+					nodeAffinities.push_back(affinity);
+				}
+			}
+
+			GROUP_AFFINITY GetProcessorAffinity(const LogicalProcessor& processor)
+			{
+				GROUP_AFFINITY affinity;
+				memset(&affinity, 0, sizeof(affinity));
+				affinity.Group = processor.group_;
+				affinity.Mask = static_cast<KAFFINITY>(1) << processor.number_;
+				return affinity;
+			}
+		}
+
+		const int ThreadPool::AnyNode;
+
+		ThreadPool::ThreadPool(unsigned int poolSize, const wstring& name, const unsigned int& maxQueryableExecutedTaskSize, const unsigned int& maxPendingTaskSize, const int& priority, const ThreadPoolMode& mode, const unsigned int& intakeCapacity, const ElasticPolicy& elasticPolicy, const WorkerPlacement& placement, const unsigned int& maxCompensatingWorkerSize, const DeadlinePolicy& deadlinePolicy)
 			:
-			poolSize_(poolSize),
-			name_(name),
 			priority_(priority),
-			maxQueryableExecutedTaskSize_(maxQueryableExecutedTaskSize),			
+			mode_(mode),
+			elasticPolicy_(elasticPolicy),
+			minPoolSize_(elasticPolicy.IsEnabled() ? elasticPolicy.minPoolSize_ : max(poolSize, 1u)),
+			maxPoolSize_(elasticPolicy.IsEnabled() ? max(elasticPolicy.maxPoolSize_, max(elasticPolicy.minPoolSize_, 1u)) : max(poolSize, 1u)),
+			maxCompensatingWorkerSize_(maxCompensatingWorkerSize),
+			workerSlotCount_(maxPoolSize_ + maxCompensatingWorkerSize),
+			startedSlotCount_(0),
+			deadlineSequence_(0),
+			deadlineTaskCount_(0),
+			deadlinePolicy_(deadlinePolicy),
+			placement_(placement),
+			latencyEpoch_(0),
+			name_(name),
+			maxQueryableExecutedTaskSize_(maxQueryableExecutedTaskSize),
 			maxPendingTaskSize_(maxPendingTaskSize),
+			poolSize_(0),
 			stop_(false),
 			enqueuedTaskCount_(0),
 			executedTaskCount_(0),
-			readyThreadCount_(0)
+			stolenTaskCount_(0),
+			skippedTaskCount_(0),
+			startedWorkerCount_(0),
+			retiredWorkerCount_(0),
+			blockedWorkerCount_(0),
+			compensatingWorkerCount_(0),
+			unpinnedWorkerCount_(0),
+			deadlineHitCount_(0),
+			deadlineMissCount_(0),
+			deadlineShedCount_(0),
+			idleThreadCount_(0),
+			blockedProducerCount_(0)
 		{
-			InitializeSRWLock(&srwLock_);
+			SetupPlacement();
+			for (size_t i = 0; i < nodes_.size() * TaskPriorityCount; i++)
+			{
+				taskQueues_.push_back(make_shared<BoundedQueue<WorkItem>>(intakeCapacity));
+			}
+
+			for (unsigned int i = 0; i < TaskPriorityCount; i++)
+			{
+				laneEnqueuedTaskCount_[i] = 0;
+				laneDispatchedTaskCount_[i] = 0;
+				laneTotalWaitTime_[i] = 0;
+				laneMaxWaitTime_[i] = 0;
+			}
+
 			Setup();
 		}
 
@@ -41,180 +152,1290 @@ namespace utils
 
 			stop_ = true;
 
-			//Signal Stop to all running threads
+			//Signal Stop to all running threads, taking the lock so that no worker is between its check and its wait
+			{
+				unique_lock<mutex> lock(queueMutex_);
+			}
 			cdv_.notify_all();
 
-			//Wait for the running task to be finished
-			for (auto thread : threads_)
+			//Release producers blocked waiting for room
+			{
+				unique_lock<mutex> lock(spaceMutex_);
+			}
+			spaceCdv_.notify_all();
+
+			//Wait for the running task to be finished, no worker is started once stop_ is set
+			vector<shared_ptr<thread>> threads;
+			{
+				lock_guard<mutex> lock(workersMutex_);
+				threads = threads_;
+			}
+
+			for (auto thread : threads)
 			{
-				thread->join();
+				if (thread && thread->joinable())
+				{
+					thread->join();
+				}
 			}
 		}
 
 		void ThreadPool::Setup()
 		{
-			for (unsigned int i = 0; i < poolSize_.load(); i++)
+			//Split the history across the minimum workers, the rings of the extra slots are only allocated once a worker runs in them
+			auto historySize = max(minPoolSize_, 1u);
+			for (unsigned int i = 0; i < workerSlotCount_; i++)
+			{
+				executedTasks_.push_back(make_shared<TaskHistory>((maxQueryableExecutedTaskSize_ + historySize - 1) / historySize));
+				exceptionTasks_.push_back(make_shared<TaskHistory>((MaxQueryableExceptionTaskSize + historySize - 1) / historySize));
+				latencies_.push_back(make_shared<LatencyRecorder>());
+			}
+
+			if (mode_ == WorkStealing)
+			{
+				for (unsigned int i = 0; i < workerSlotCount_; i++)
+				{
+					workerQueues_.push_back(make_shared<WorkerQueue>());
+				}
+			}
+
+			lock_guard<mutex> lock(workersMutex_);
+			threads_.resize(workerSlotCount_);
+			activeWorkers_.resize(workerSlotCount_, false);
+			for (unsigned int i = 0; i < minPoolSize_; i++)
+			{
+				StartWorker(i);
+			}
+		}
+
+		void ThreadPool::SetupPlacement()
+		{
+			GROUP_AFFINITY floating;
+			memset(&floating, 0, sizeof(floating));
+			workerNodes_.assign(workerSlotCount_, 0);
+			workerAffinities_.assign(workerSlotCount_, floating);
+
+			vector<unsigned int> nodes;
+			vector<GROUP_AFFINITY> nodeAffinities;
+			vector<LogicalProcessor> processors;
+			if (placement_.policy_ != NoPlacement)
+			{
+				GetTopology(nodes, nodeAffinities, processors);
+			}
+
+			if (processors.empty())
+			{
+				//No placement, or the topology is not available: float with a single set of queues
+				placement_.policy_ = NoPlacement;
+				nodes_.assign(1, 0);
+				return;
+			}
+
+			nodes_ = nodes;
+			for (auto& processor : processors)
 			{
-				auto th = make_shared<thread>([this]()
+				auto id = processor.group_ * GroupProcessorCount + processor.number_;
+				if (processorNodes_.size() <= id)
 				{
-					auto hThread = ::GetCurrentThread();
-					auto currentPriority = ::GetThreadPriority(hThread);				
+					processorNodes_.resize(id + 1, 0);
+				}
+				processorNodes_[id] = processor.node_;
+			}
+
+			//Processors of every node, in order
+			vector<vector<LogicalProcessor>> nodeProcessors(nodes_.size());
+			for (auto& processor : processors)
+			{
+				nodeProcessors[processor.node_].push_back(processor);
+			}
 
-					if (priority_ != currentPriority)
+			for (unsigned int i = 0; i < workerSlotCount_; i++)
+			{
+				switch (placement_.policy_)
+				{
+				case Compact:
+				{
+					auto& processor = processors[i % processors.size()];
+					workerNodes_[i] = processor.node_;
+					workerAffinities_[i] = GetProcessorAffinity(processor);
+					break;
+				}
+				case Scatter:
+				{
+					auto node = i % static_cast<unsigned int>(nodes_.size());
+					auto& candidates = nodeProcessors[node];
+					auto& processor = candidates[(i / nodes_.size()) % candidates.size()];
+					workerNodes_[i] = node;
+					workerAffinities_[i] = GetProcessorAffinity(processor);
+					break;
+				}
+				case PerNode:
+				{
+					auto node = i % static_cast<unsigned int>(nodes_.size());
+					workerNodes_[i] = node;
+					workerAffinities_[i] = nodeAffinities[node];
+					break;
+				}
+				case CpuList:
+				{
+					if (placement_.cpus_.empty())
 					{
-						auto result = ::SetThreadPriority(hThread, priority_);
-						if (!result)
-						{
-							throw runtime_error("Fail to set up thread priority");						
-						}
+						break;
 					}
 
-					try
+					//An unknown processor leaves the worker floating
+					auto id = placement_.cpus_[i % placement_.cpus_.size()];
+					for (auto& processor : processors)
 					{
-						shared_ptr<Task> pTask;
-						while (!stop_.load())
+						if (processor.group_ * GroupProcessorCount + processor.number_ == id)
 						{
-							{
-								// acquire lock
-								unique_lock<mutex> lock(queueMutex_);
-
-								// look for a work item
-								while (!stop_.load() && taskQueue_.empty())
-								{
-									if (readyThreadCount_.load() < poolSize_.load())
-									{
-										readyThreadCount_++;
-									}
-									cdv_.wait(lock);
-								}
-
-								// exit if the pool is stopped
-								if (stop_.load())
-								{
-									return;
-								}
-
-								// get the task from the queue
-								pTask = taskQueue_.front();
-
-								taskQueue_.pop_front();
-
-							}// release lock							
-
-							try
-							{
-								pTask->Run(); // execute the task								
-							}
-							catch (std::exception& ex)
-							{
-								//log ex
-								UNREFERENCED_PARAMETER(ex);
-								utils::WriteLock lock(srwLock_);
-								//Only keep 1000 exception tasks
-								if (exceptionTasks_.size() > 1000)
-								{
-									exceptionTasks_.pop_front();
-								}
-
-								exceptionTasks_.push_back(pTask);
-							}
-							catch (...)
-							{
-								//log exception
-								utils::WriteLock lock(srwLock_);
-								if (exceptionTasks_.size() > 1000)
-								{
-									exceptionTasks_.pop_front();
-								}
-								exceptionTasks_.push_back(pTask);
-							}
-
-							executedTaskCount_++;
-
-							{
-								utils::WriteLock lock(srwLock_);
-								if (executedTasks_.size() > maxQueryableExecutedTaskSize_)
-								{
-									executedTasks_.pop_front();
-								}
-
-								executedTasks_.push_back(pTask);
-							}
+							workerNodes_[i] = processor.node_;
+							workerAffinities_[i] = GetProcessorAffinity(processor);
+							break;
 						}
 					}
-					catch (std::exception& ex)
-					{
-						//log fatal error
-						UNREFERENCED_PARAMETER(ex);
-					}
-					catch (...)
+					break;
+				}
+				default:
+					break;
+				}
+			}
+		}
+
+		void ThreadPool::StartWorker(unsigned int index)
+		{
+			//The slot's previous worker has retired, it only has to return
+			auto& th = threads_[index];
+			if (th && th->joinable())
+			{
+				th->join();
+			}
+
+			activeWorkers_[index] = true;
+			poolSize_++;
+			startedWorkerCount_++;
+			if (startedSlotCount_.load() <= index)
+			{
+				startedSlotCount_ = index + 1;
+			}
+
+			th = make_shared<thread>([this, index]()
+			{
+				auto hThread = ::GetCurrentThread();
+				auto currentPriority = ::GetThreadPriority(hThread);
+
+				if (priority_ != currentPriority)
+				{
+					auto result = ::SetThreadPriority(hThread, priority_);
+					if (!result)
 					{
-						//Log fatal error
+						throw runtime_error("Fail to set up thread priority");
 					}
-				});
+				}
+
+				//A worker that cannot be pinned still runs, only floating
+				auto& affinity = workerAffinities_[index];
+				auto pinned = affinity.Mask != 0 && ::SetThreadGroupAffinity(hThread, &affinity, nullptr);
+				if (!pinned && placement_.policy_ != NoPlacement)
+				{
+					unpinnedWorkerCount_++;
+				}
+
+				try
+				{
+					RunWorker(index);
+				}
+				catch (std::exception& ex)
+				{
+					//log fatal error
+					UNREFERENCED_PARAMETER(ex);
+				}
+				catch (...)
+				{
+					//Log fatal error
+				}
+			});
+		}
+
+		bool ThreadPool::TryAddWorker()
+		{
+			//Blocked workers do not count against the maximum, up to maxCompensatingWorkerSize_ of them
+			auto maxPoolSize = [this]() { return maxPoolSize_ + min(blockedWorkerCount_.load(), maxCompensatingWorkerSize_); };
+			if (poolSize_.load() >= maxPoolSize() || idleThreadCount_.load() > 0)
+			{
+				return false;
+			}
+
+			lock_guard<mutex> lock(workersMutex_);
+			if (stop_.load() || poolSize_.load() >= maxPoolSize())
+			{
+				return false;
+			}
 
-				threads_.push_back(th);			
+			for (unsigned int i = 0; i < workerSlotCount_; i++)
+			{
+				if (!activeWorkers_[i])
+				{
+					StartWorker(i);
+					return true;
+				}
 			}
 
-			while (readyThreadCount_.load() != poolSize_.load())
+			return false;
+		}
+
+		bool ThreadPool::TryRetireWorker(unsigned int index)
+		{
+			lock_guard<mutex> lock(workersMutex_);
+			if (stop_.load() || poolSize_.load() <= minPoolSize_ + blockedWorkerCount_.load())
 			{
-				Sleep(200);
+				return false;
 			}
+
+			activeWorkers_[index] = false;
+			poolSize_--;
+			retiredWorkerCount_++;
+			return true;
+		}
+
+		bool ThreadPool::HasSurplusWorker() const
+		{
+			return poolSize_.load() > maxPoolSize_ + blockedWorkerCount_.load();
 		}
 
-		bool ThreadPool::Enqueue(shared_ptr<Task> task)
+		bool ThreadPool::TryRetireSurplusWorker(unsigned int index)
 		{
-			if (GetPendingTaskCount() > maxPendingTaskSize_)
+			//Tasks in the worker's own deque would be left behind
+			if (mode_ == WorkStealing && workerQueues_[index]->size_.load() > 0)
 			{
-				//log wait for a monment to allow the thread pool execute existing pending tasks				
 				return false;
 			}
 
+			lock_guard<mutex> lock(workersMutex_);
+			if (stop_.load() || !HasSurplusWorker())
 			{
-				unique_lock<mutex> lock(queueMutex_);
-				taskQueue_.push_back(task);
+				return false;
 			}
 
-			enqueuedTaskCount_++;
-			cdv_.notify_one();
+			activeWorkers_[index] = false;
+			poolSize_--;
+			retiredWorkerCount_++;
 			return true;
 		}
 
-		std::vector<std::shared_ptr<Task>> ThreadPool::GetExceptionTasks() const
+		void ThreadPool::EnterBlocking()
+		{
+			blockedWorkerCount_++;
+
+			//An idle worker already stands by for the queued tasks
+			if (TryAddWorker())
+			{
+				compensatingWorkerCount_++;
+			}
+		}
+
+		void ThreadPool::LeaveBlocking()
 		{
-			utils::ReadLock lock(srwLock_);
-			return std::move(std::vector<std::shared_ptr<Task>>(exceptionTasks_.begin(), exceptionTasks_.end()));
+			blockedWorkerCount_--;
+
+			//Wake the idle workers so that a surplus one retires, busy ones retire after their task
+			if (HasSurplusWorker() && idleThreadCount_.load() > 0)
+			{
+				{
+					unique_lock<mutex> lock(queueMutex_);
+				}
+				cdv_.notify_all();
+			}
 		}
 
-		std::vector<std::shared_ptr<Task>> ThreadPool::GetExecutedTasks() const
+		ThreadPool::BlockingRegion::BlockingRegion()
+			:
+			pPool_(nullptr)
 		{
-			utils::ReadLock lock(srwLock_);
-			return std::move(std::vector<std::shared_ptr<Task>>(executedTasks_.begin(), executedTasks_.end()));			
+			if (currentPool && !currentBlocked)
+			{
+				pPool_ = currentPool;
+				currentBlocked = true;
+				pPool_->EnterBlocking();
+			}
 		}
 
-		unsigned long long ThreadPool::GetEnqueuedTaskCount() const
+		ThreadPool::BlockingRegion::~BlockingRegion()
 		{
-			return enqueuedTaskCount_.load();
+			if (pPool_)
+			{
+				pPool_->LeaveBlocking();
+				currentBlocked = false;
+			}
 		}
 
-		unsigned long long ThreadPool::GetExecutedTaskCount() const
+		void ThreadPool::RunWorker(unsigned int index)
 		{
-			return executedTaskCount_.load();
+			currentPool = this;
+			currentWorkerIndex = index;
+
+			auto elastic = elasticPolicy_.IsEnabled();
+			unsigned int slowDispatchCount = 0;
+			//Items this worker dequeued, polls that found nothing do not count so that the lower lanes get their turn every so many dispatches
+			unsigned long long dispatchCount = 0;
+			WorkItem item;
+			while (!stop_.load())
+			{
+				if (TryDequeue(index, dispatchCount + 1, item))
+				{
+					dispatchCount++;
+					auto dispatchTime = chrono::steady_clock::now();
+					auto waitTime = RecordDispatch(item, dispatchTime);
+					if (elastic)
+					{
+						//Tasks keep waiting, the workers cannot keep up
+						slowDispatchCount = (waitTime > elasticPolicy_.queueWaitThreshold_) ? slowDispatchCount + 1 : 0;
+						if (slowDispatchCount >= SustainedSlowDispatchCount)
+						{
+							slowDispatchCount = 0;
+							TryAddWorker();
+						}
+					}
+
+					Execute(index, item, dispatchTime);
+
+					//A blocked worker came back, one worker too many runs
+					if (HasSurplusWorker() && TryRetireSurplusWorker(index))
+					{
+						return;
+					}
+					continue;
+				}
+
+				// nothing to run, park until a producer signals new work
+				unique_lock<mutex> lock(queueMutex_);
+				idleThreadCount_++;
+
+				// re-check after announcing idleness, a producer that did not see us idle must have published before this scan
+				atomic_thread_fence(memory_order_seq_cst);
+				auto retired = false;
+				auto idleDeadline = chrono::steady_clock::now() + elasticPolicy_.keepAlive_;
+				while (!stop_.load() && !HasQueuedTask())
+				{
+					if (HasSurplusWorker())
+					{
+						retired = TryRetireSurplusWorker(index);
+						if (retired)
+						{
+							break;
+						}
+					}
+
+					if (!elastic)
+					{
+						cdv_.wait(lock);
+					}
+					else if (cdv_.wait_until(lock, idleDeadline) == cv_status::timeout && !HasQueuedTask())
+					{
+						//Idle for the whole keep-alive, leave unless the pool is at its minimum
+						retired = TryRetireWorker(index);
+						if (retired)
+						{
+							break;
+						}
+
+						idleDeadline = chrono::steady_clock::now() + elasticPolicy_.keepAlive_;
+					}
+				}
+
+				idleThreadCount_--;
+				if (retired)
+				{
+					return;
+				}
+			}
 		}
 
-		unsigned long long ThreadPool::GetPendingTaskCount() const
+		bool ThreadPool::TryDequeue(unsigned int index, unsigned long long dispatchCount, WorkItem& item)
 		{
-			return enqueuedTaskCount_.load() - executedTaskCount_.load();
+			//Deadline tasks go ahead of the lanes, the count is always zero outside EarliestDeadlineFirst mode
+			if (deadlineTaskCount_.load(memory_order_relaxed) > 0 && TryDequeueDeadline(item))
+			{
+				return true;
+			}
+
+			//Drain the lanes in priority order, but let a lower lane go first now and then so that it cannot starve
+			auto first = (dispatchCount % BackgroundLaneInterval == 0) ? Background : ((dispatchCount % NormalLaneInterval == 0) ? Normal : Critical);
+			if (TryDequeueLane(index, first, item))
+			{
+				return true;
+			}
+
+			for (unsigned int i = 0; i < TaskPriorityCount; i++)
+			{
+				auto priority = static_cast<TaskPriority>(i);
+				if (priority != first && TryDequeueLane(index, priority, item))
+				{
+					return true;
+				}
+			}
+
+			return false;
 		}
 
-		wstring ThreadPool::GetName() const
+		bool ThreadPool::TryDequeueLane(unsigned int index, const TaskPriority& priority, WorkItem& item)
 		{
-			return name_;
+			if (priority == Normal && mode_ == WorkStealing)
+			{
+				return TryPopLocal(index, item) || TryDequeueIntake(index, priority, item) || TrySteal(index, item);
+			}
+
+			return TryDequeueIntake(index, priority, item);
 		}
 
-		unsigned int ThreadPool::GetPoolSize() const
+		bool ThreadPool::TryDequeueDeadline(WorkItem& item)
 		{
-			return poolSize_;
+			auto found = false;
+			unsigned long long shedCount = 0;
+			{
+				lock_guard<mutex> lock(deadlineMutex_);
+				auto now = (deadlinePolicy_ == RunLate) ? chrono::steady_clock::time_point::min() : chrono::steady_clock::now();
+				while (!found && !deadlineQueue_.empty())
+				{
+					pop_heap(deadlineQueue_.begin(), deadlineQueue_.end(), DeadlineItemSorter());
+					auto& entry = deadlineQueue_.back();
+					if (entry.deadline_ >= now)
+					{
+						item = std::move(entry.item_);
+						deadlineTaskCount_--;
+						found = true;
+					}
+					else if (deadlinePolicy_ == DeprioritizeLate)
+					{
+						lateItems_.push_back(std::move(entry.item_));
+					}
+					else
+					{
+						//Shed: it leaves its lane without ever being dispatched
+						entry.item_.pTask_->SetState(Expired);
+						laneDispatchedTaskCount_[entry.item_.priority_]++;
+						deadlineTaskCount_--;
+						shedCount++;
+					}
+					deadlineQueue_.pop_back();
+				}
+
+				//Only late tasks are left
+				if (!found && !lateItems_.empty())
+				{
+					item = std::move(lateItems_.front());
+					lateItems_.pop_front();
+					deadlineTaskCount_--;
+					found = true;
+				}
+			}
+
+			if (shedCount > 0)
+			{
+				deadlineShedCount_ += shedCount;
+				skippedTaskCount_ += shedCount;
+				NotifyProducer();
+			}
+
+			return found;
+		}
+
+		bool ThreadPool::TryDequeueIntake(unsigned int index, const TaskPriority& priority, WorkItem& item)
+		{
+			auto nodeCount = static_cast<unsigned int>(nodes_.size());
+			auto node = workerNodes_[index];
+			for (unsigned int i = 0; i < nodeCount; i++)
+			{
+				if (GetIntakeQueue((node + i) % nodeCount, priority).TryDequeue(item))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		BoundedQueue<WorkItem>& ThreadPool::GetIntakeQueue(const unsigned int& node, const TaskPriority& priority) const
+		{
+			return *taskQueues_[node * TaskPriorityCount + priority];
+		}
+
+		unsigned int ThreadPool::ResolveNode(const int& node) const
+		{
+			if (nodes_.size() == 1)
+			{
+				return 0;
+			}
+
+			if (node != AnyNode)
+			{
+				auto it = find(nodes_.begin(), nodes_.end(), static_cast<unsigned int>(node));
+				return it != nodes_.end() ? static_cast<unsigned int>(it - nodes_.begin()) : static_cast<unsigned int>(static_cast<size_t>(node) % nodes_.size());
+			}
+
+			if (currentPool == this)
+			{
+				return workerNodes_[currentWorkerIndex];
+			}
+
+			PROCESSOR_NUMBER processor;
+			::GetCurrentProcessorNumberEx(&processor);
+			auto id = processor.Group * GroupProcessorCount + processor.Number;
+			return id < processorNodes_.size() ? processorNodes_[id] : 0;
+		}
+
+		chrono::steady_clock::duration ThreadPool::RecordDispatch(const WorkItem& item, const chrono::steady_clock::time_point& dispatchTime)
+		{
+			auto priority = item.priority_;
+			auto elapsed = dispatchTime - item.enqueueTime_;
+			auto waitTime = static_cast<unsigned long long>(chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+
+			laneDispatchedTaskCount_[priority]++;
+			laneTotalWaitTime_[priority] += waitTime;
+
+			auto maxWaitTime = laneMaxWaitTime_[priority].load(memory_order_relaxed);
+			while (waitTime > maxWaitTime && !laneMaxWaitTime_[priority].compare_exchange_weak(maxWaitTime, waitTime, memory_order_relaxed))
+			{
+			}
+
+			return elapsed;
+		}
+
+		bool ThreadPool::HasQueuedTask() const
+		{
+			if (deadlineTaskCount_.load() > 0)
+			{
+				return true;
+			}
+
+			for (auto& pQueue : taskQueues_)
+			{
+				if (!pQueue->IsEmpty())
+				{
+					return true;
+				}
+			}
+
+			//Slots no worker ever started in have empty deques
+			auto startedSlotCount = min<size_t>(startedSlotCount_.load(), workerQueues_.size());
+			for (size_t i = 0; i < startedSlotCount; i++)
+			{
+				if (workerQueues_[i]->size_.load() > 0)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool ThreadPool::TryPopLocal(unsigned int index, WorkItem& item)
+		{
+			auto& queue = *workerQueues_[index];
+			if (queue.size_.load() == 0)
+			{
+				return false;
+			}
+
+			lock_guard<mutex> lock(queue.mutex_);
+			if (queue.tasks_.empty())
+			{
+				return false;
+			}
+
+			// own end, LIFO
+			item = std::move(queue.tasks_.back());
+			queue.tasks_.pop_back();
+			queue.size_--;
+			return true;
+		}
+
+		bool ThreadPool::TrySteal(unsigned int index, WorkItem& item)
+		{
+			//Steal from the peers of the same node first, from the other nodes' only when they have nothing.
+			//Only the slots a worker started in can hold tasks.
+			auto size = min(startedSlotCount_.load(), static_cast<unsigned int>(workerQueues_.size()));
+			auto node = workerNodes_[index];
+			for (unsigned int i = 1; i < 2 * size; i++)
+			{
+				auto peer = (index + i) % size;
+				if (peer == index || ((i < size) != (workerNodes_[peer] == node)))
+				{
+					continue;
+				}
+
+				auto& queue = *workerQueues_[peer];
+				if (queue.size_.load() == 0)
+				{
+					continue;
+				}
+
+				lock_guard<mutex> lock(queue.mutex_);
+				if (queue.tasks_.empty())
+				{
+					continue;
+				}
+
+				// the peer's far end, FIFO
+				item = std::move(queue.tasks_.front());
+				queue.tasks_.pop_front();
+				queue.size_--;
+				stolenTaskCount_++;
+				return true;
+			}
+
+			return false;
+		}
+
+		void ThreadPool::Execute(unsigned int index, WorkItem& item, const chrono::steady_clock::time_point& dispatchTime)
+		{
+			//A cancelled task is dropped here, when it comes out of the queue, the queue itself is never searched
+			if (item.pTask_ && item.pTask_->IsCancellationRequested())
+			{
+				item.pTask_->SetState(Cancelled);
+				item = WorkItem();
+				skippedTaskCount_++;
+				NotifyProducer();
+				return;
+			}
+
+			TaskRecord record;
+			record.nameId_ = 0;
+			record.state_ = Complete;
+			record.priority_ = item.priority_;
+			record.errorCode_ = NoError;
+			record.enqueueTime_ = item.enqueueTime_;
+
+			if (item.pTask_)
+			{
+				auto& pTask = item.pTask_;
+				try
+				{
+					if (pTask->IsBlocking())
+					{
+						BlockingRegion blocking;
+						pTask->Run();
+					}
+					else
+					{
+						pTask->Run(); // execute the task
+					}
+				}
+				catch (std::exception& ex)
+				{
+					//log ex
+					UNREFERENCED_PARAMETER(ex);
+					record.errorCode_ = (pTask->GetState() == Complete) ? CallbackException : ActionException;
+				}
+				catch (...)
+				{
+					//log exception
+					record.errorCode_ = UnknownException;
+				}
+
+				if (pTask->HasDeadline())
+				{
+					auto hit = record.errorCode_ == NoError && chrono::steady_clock::now() <= pTask->GetDeadline();
+					(hit ? deadlineHitCount_ : deadlineMissCount_)++;
+				}
+
+				record.nameId_ = pTask->GetNameId();
+				record.state_ = pTask->GetState();
+				record.startTime_ = pTask->GetStartTime();
+				record.completeTime_ = pTask->GetCompleteTime();
+			}
+			else
+			{
+				//Submitted calls hand their exception to the future, they only throw if that fails
+				record.startTime_ = chrono::system_clock::now();
+				try
+				{
+					item.function_();
+				}
+				catch (...)
+				{
+					record.state_ = Terminated;
+					record.errorCode_ = UnknownException;
+				}
+				record.completeTime_ = chrono::system_clock::now();
+			}
+
+			auto runTime = chrono::steady_clock::now() - dispatchTime;
+			auto waitTime = dispatchTime - item.enqueueTime_;
+			latencies_[index]->Record(latencyEpoch_.load(memory_order_relaxed), record.nameId_,
+				static_cast<unsigned long long>(chrono::duration_cast<chrono::nanoseconds>(waitTime).count()),
+				static_cast<unsigned long long>(chrono::duration_cast<chrono::nanoseconds>(runTime).count()));
+
+			//Release the task or the call, together with whatever its closures captured
+			item = WorkItem();
+
+			executedTaskCount_++;
+			NotifyProducer();
+
+			if (record.errorCode_ != NoError)
+			{
+				exceptionTasks_[index]->Add(record);
+			}
+
+			executedTasks_[index]->Add(record);
+		}
+
+		void ThreadPool::NotifyProducer()
+		{
+			//A pending slot is free again, wake a producer blocked in Enqueue/EnqueueFor
+			if (blockedProducerCount_.load() > 0)
+			{
+				unique_lock<mutex> lock(spaceMutex_);
+				spaceCdv_.notify_one();
+			}
+		}
+
+		template <typename TPriorityOf, typename TMakeItem>
+		size_t ThreadPool::PublishBatch(size_t count, const unsigned int& node, TPriorityOf priorityOf, TMakeItem makeItem)
+		{
+			auto pendingTaskCount = GetPendingTaskCount();
+			if (stop_.load() || count == 0 || pendingTaskCount > maxPendingTaskSize_)
+			{
+				//log wait for a monment to allow the thread pool execute existing pending tasks
+				return 0;
+			}
+
+			count = static_cast<size_t>(min<unsigned long long>(count, maxPendingTaskSize_ - pendingTaskCount + 1));
+
+			//Count before publishing so that a worker can never execute the tasks before they are counted
+			enqueuedTaskCount_ += count;
+
+			//Publish each run of items sharing the same priority to its lane in one go
+			size_t published = 0;
+			while (published < count)
+			{
+				auto priority = priorityOf(published);
+				size_t run = 1;
+				while (published + run < count && priorityOf(published + run) == priority)
+				{
+					run++;
+				}
+
+				auto pushed = PublishRun(published, run, node, priority, makeItem);
+				published += pushed;
+				if (pushed < run)
+				{
+					break;
+				}
+			}
+
+			if (published < count)
+			{
+				enqueuedTaskCount_ -= (count - published);
+			}
+
+			WakeWorkers(published);
+			return published;
+		}
+
+		template <typename TMakeItem>
+		size_t ThreadPool::PublishRun(size_t first, size_t count, const unsigned int& node, const TaskPriority& priority, TMakeItem& makeItem)
+		{
+			//Count before publishing so that the lane depth can never go below zero
+			laneEnqueuedTaskCount_[priority] += count;
+
+			size_t published = 0;
+			if (priority == Normal && mode_ == WorkStealing && currentPool == this)
+			{
+				auto& queue = *workerQueues_[currentWorkerIndex];
+				lock_guard<mutex> lock(queue.mutex_);
+				for (size_t i = 0; i < count; i++)
+				{
+					queue.tasks_.push_back(makeItem(first + i));
+				}
+				queue.size_ += count;
+				published = count;
+			}
+			else
+			{
+				//The ring reserves only the consecutive cells already free, which may be fewer than asked: reserve again until the run is published or the ring is full
+				size_t pushed;
+				auto& queue = GetIntakeQueue(node, priority);
+				while (published < count && (pushed = queue.TryEnqueueRange(count - published, [&](size_t i) { return makeItem(first + published + i); })) > 0)
+				{
+					published += pushed;
+				}
+			}
+
+			if (published < count)
+			{
+				laneEnqueuedTaskCount_[priority] -= (count - published);
+			}
+
+			return published;
+		}
+
+		void ThreadPool::WakeWorkers(size_t count)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			atomic_thread_fence(memory_order_seq_cst);
+			auto idleThreadCount = idleThreadCount_.load();
+			if (idleThreadCount > 0)
+			{
+				unique_lock<mutex> lock(queueMutex_);
+				if (count >= idleThreadCount)
+				{
+					cdv_.notify_all();
+				}
+				else
+				{
+					for (size_t i = 0; i < count; i++)
+					{
+						cdv_.notify_one();
+					}
+				}
+			}
+
+			//An elastic pool with no minimum may have retired all of its workers, start one for the new work.
+			//A worker retires under queueMutex_, so it is either counted here or it did see the work before leaving.
+			if (poolSize_.load() == 0)
+			{
+				TryAddWorker();
+			}
+		}
+
+		size_t ThreadPool::TryEnqueueBatch(const vector<shared_ptr<Task>>& tasks)
+		{
+			return TryEnqueueBatch(tasks.data(), tasks.size(), ResolveNode(AnyNode));
+		}
+
+		size_t ThreadPool::TryEnqueueBatch(const shared_ptr<Task>* pTasks, size_t count, const unsigned int& node)
+		{
+			if (mode_ != EarliestDeadlineFirst)
+			{
+				return PublishTasks(pTasks, count, node);
+			}
+
+			//Publish each run of tasks with and without a deadline in one go, in order
+			size_t published = 0;
+			while (published < count)
+			{
+				auto deadline = IsDeadlineTask(pTasks[published]);
+				size_t run = 1;
+				while (published + run < count && IsDeadlineTask(pTasks[published + run]) == deadline)
+				{
+					run++;
+				}
+
+				auto pushed = deadline ? PublishDeadline(pTasks + published, run) : PublishTasks(pTasks + published, run, node);
+				published += pushed;
+				if (pushed < run)
+				{
+					break;
+				}
+			}
+
+			return published;
+		}
+
+		bool ThreadPool::IsDeadlineTask(const shared_ptr<Task>& pTask) const
+		{
+			return mode_ == EarliestDeadlineFirst && pTask && pTask->HasDeadline();
+		}
+
+		size_t ThreadPool::PublishDeadline(const shared_ptr<Task>* pTasks, size_t count)
+		{
+			auto pendingTaskCount = GetPendingTaskCount();
+			if (stop_.load() || count == 0 || pendingTaskCount > maxPendingTaskSize_)
+			{
+				return 0;
+			}
+
+			count = static_cast<size_t>(min<unsigned long long>(count, maxPendingTaskSize_ - pendingTaskCount + 1));
+			enqueuedTaskCount_ += count;
+
+			auto now = chrono::steady_clock::now();
+			{
+				lock_guard<mutex> lock(deadlineMutex_);
+				for (size_t i = 0; i < count; i++)
+				{
+					auto& pTask = pTasks[i];
+					pTask->SetEnqueueTime(now);
+					laneEnqueuedTaskCount_[pTask->GetPriority()]++;
+					deadlineQueue_.push_back(DeadlineItem(pTask->GetDeadline(), deadlineSequence_++, WorkItem(pTask, pTask->GetPriority(), now)));
+					push_heap(deadlineQueue_.begin(), deadlineQueue_.end(), DeadlineItemSorter());
+				}
+				deadlineTaskCount_ += count;
+			}
+
+			WakeWorkers(count);
+			return count;
+		}
+
+		size_t ThreadPool::PublishTasks(const shared_ptr<Task>* pTasks, size_t count, const unsigned int& node)
+		{
+			auto now = chrono::steady_clock::now();
+			return PublishBatch(count, node,
+				[pTasks](size_t i) { return pTasks[i]->GetPriority(); },
+				[pTasks, &now](size_t i)
+				{
+					pTasks[i]->SetEnqueueTime(now);
+					return WorkItem(pTasks[i], pTasks[i]->GetPriority(), now);
+				});
+		}
+
+		bool ThreadPool::TryEnqueue(shared_ptr<Task> task, const int& node)
+		{
+			if (!task)
+			{
+				return false;
+			}
+
+			return TryEnqueueBatch(&task, 1, ResolveNode(node)) == 1;
+		}
+
+		size_t ThreadPool::EnqueueBatch(const vector<shared_ptr<Task>>& tasks)
+		{
+			auto node = ResolveNode(AnyNode);
+			size_t published = 0;
+			while (published < tasks.size())
+			{
+				auto pushed = TryEnqueueBatch(tasks.data() + published, tasks.size() - published, node);
+				if (pushed == 0)
+				{
+					//Out of room, wait for it with the next task and then go on in bulk
+					if (!Enqueue(tasks[published], static_cast<int>(nodes_[node])))
+					{
+						break;
+					}
+					pushed = 1;
+				}
+				published += pushed;
+			}
+
+			return published;
+		}
+
+		size_t ThreadPool::EnqueueBatch(const vector<function<void()>>& actions, const string& name)
+		{
+			vector<shared_ptr<Task>> tasks;
+			tasks.reserve(actions.size());
+			for (auto& action : actions)
+			{
+				tasks.push_back(make_shared<Task>(action, name));
+			}
+
+			return EnqueueBatch(tasks);
+		}
+
+		bool ThreadPool::Enqueue(shared_ptr<Task> task, const int& node)
+		{
+			return EnqueueFor(task, chrono::steady_clock::duration::max(), node);
+		}
+
+		bool ThreadPool::EnqueueFor(shared_ptr<Task> task, const chrono::steady_clock::duration& timeout, const int& node)
+		{
+			if (!task)
+			{
+				return false;
+			}
+
+			task->SetEnqueueTime(chrono::steady_clock::now());
+			WorkItem item(task, task->GetPriority(), task->GetEnqueueTime());
+			return EnqueueItem(item, ResolveNode(node), timeout);
+		}
+
+		bool ThreadPool::EnqueueItem(WorkItem& item, const unsigned int& node, const chrono::steady_clock::duration& timeout)
+		{
+			auto now = chrono::steady_clock::now();
+			auto deadline = (timeout >= chrono::steady_clock::time_point::max() - now) ? chrono::steady_clock::time_point::max() : now + timeout;
+			auto priorityOf = [&item](size_t) { return item.priority_; };
+			auto makeItem = [&item](size_t)
+			{
+				item.enqueueTime_ = chrono::steady_clock::now();
+				return std::move(item);
+			};
+
+			//A task with a deadline is copied into the deadline queue, item is then left as is
+			auto publish = [&]() { return IsDeadlineTask(item.pTask_) ? PublishDeadline(&item.pTask_, 1) == 1 : PublishBatch(1, node, priorityOf, makeItem) == 1; };
+
+			for (;;)
+			{
+				if (publish())
+				{
+					return true;
+				}
+
+				if (stop_.load() || chrono::steady_clock::now() >= deadline)
+				{
+					return false;
+				}
+
+				//A worker of this pool waiting for room could wait on itself, run the task inline instead
+				if (currentPool == this)
+				{
+					enqueuedTaskCount_++;
+					auto dispatchTime = chrono::steady_clock::now();
+					item.enqueueTime_ = dispatchTime;
+					Execute(currentWorkerIndex, item, dispatchTime);
+					return true;
+				}
+
+				unique_lock<mutex> lock(spaceMutex_);
+				blockedProducerCount_++;
+
+				// retry after announcing ourselves, a worker that freed room before seeing us blocked did not notify
+				auto published = publish();
+				if (!published && !stop_.load())
+				{
+					if (deadline == chrono::steady_clock::time_point::max())
+					{
+						spaceCdv_.wait(lock);
+					}
+					else
+					{
+						spaceCdv_.wait_until(lock, deadline);
+					}
+				}
+
+				blockedProducerCount_--;
+
+				if (published)
+				{
+					return true;
+				}
+			}
+		}
+
+		vector<TaskRecord> ThreadPool::GetExceptionTasks() const
+		{
+			return MergeHistories(exceptionTasks_, MaxQueryableExceptionTaskSize);
+		}
+
+		vector<TaskRecord> ThreadPool::GetExecutedTasks() const
+		{
+			return MergeHistories(executedTasks_, maxQueryableExecutedTaskSize_);
+		}
+
+		LatencyReport ThreadPool::GetLatency() const
+		{
+			auto epoch = latencyEpoch_.load();
+			LatencyReport report;
+			for (auto& pLatency : latencies_)
+			{
+				pLatency->CopyTo(epoch, report);
+			}
+
+			return report;
+		}
+
+		LatencyReport ThreadPool::GetWorkerLatency(const unsigned int& index) const
+		{
+			LatencyReport report;
+			if (index < latencies_.size())
+			{
+				latencies_[index]->CopyTo(latencyEpoch_.load(), report);
+			}
+
+			return report;
+		}
+
+		unordered_map<string, LatencyReport> ThreadPool::GetLatencyByName() const
+		{
+			auto epoch = latencyEpoch_.load();
+			unordered_map<unsigned int, LatencyReport> reports;
+			for (auto& pLatency : latencies_)
+			{
+				pLatency->CopyTo(epoch, reports);
+			}
+
+			unordered_map<string, LatencyReport> namedReports;
+			for (auto& report : reports)
+			{
+				//Only the names that ran since the last reset
+				if (report.second.run_.GetCount() > 0)
+				{
+					namedReports[Task::GetNameById(report.first)] = report.second;
+				}
+			}
+
+			return namedReports;
+		}
+
+		void ThreadPool::ResetLatency()
+		{
+			latencyEpoch_++;
+		}
+
+		vector<TaskRecord> ThreadPool::MergeHistories(const vector<shared_ptr<TaskHistory>>& histories, const size_t& maxSize) const
+		{
+			vector<TaskRecord> records;
+			for (auto& pHistory : histories)
+			{
+				pHistory->CopyTo(records);
+			}
+
+			//A task that threw in its action has no complete time, order it by its start time
+			auto orderTime = [](const TaskRecord& record)
+			{
+				return record.completeTime_ == chrono::system_clock::time_point() ? record.startTime_ : record.completeTime_;
+			};
+
+			stable_sort(records.begin(), records.end(), [&orderTime](const TaskRecord& left, const TaskRecord& right)
+			{
+				return orderTime(left) < orderTime(right);
+			});
+
+			if (records.size() > maxSize)
+			{
+				records.erase(records.begin(), records.begin() + (records.size() - maxSize));
+			}
+
+			return records;
+		}
+
+		unsigned long long ThreadPool::GetEnqueuedTaskCount() const
+		{
+			return enqueuedTaskCount_.load();
+		}
+
+		unsigned long long ThreadPool::GetExecutedTaskCount() const
+		{
+			return executedTaskCount_.load();
+		}
+
+		unsigned long long ThreadPool::GetPendingTaskCount() const
+		{
+			//Read the finished tasks first, they never outnumber the tasks enqueued before
+			auto finishedTaskCount = executedTaskCount_.load() + skippedTaskCount_.load();
+			return enqueuedTaskCount_.load() - finishedTaskCount;
+		}
+
+		unsigned long long ThreadPool::GetPendingTaskCount(const TaskPriority& priority) const
+		{
+			auto dispatchedTaskCount = laneDispatchedTaskCount_[priority].load();
+			auto enqueuedTaskCount = laneEnqueuedTaskCount_[priority].load();
+			return enqueuedTaskCount > dispatchedTaskCount ? enqueuedTaskCount - dispatchedTaskCount : 0;
+		}
+
+		unsigned long long ThreadPool::GetDispatchedTaskCount(const TaskPriority& priority) const
+		{
+			return laneDispatchedTaskCount_[priority].load();
+		}
+
+		chrono::nanoseconds ThreadPool::GetAverageWaitTime(const TaskPriority& priority) const
+		{
+			auto dispatchedTaskCount = laneDispatchedTaskCount_[priority].load();
+			if (dispatchedTaskCount == 0)
+			{
+				return chrono::nanoseconds(0);
+			}
+
+			return chrono::nanoseconds(laneTotalWaitTime_[priority].load() / dispatchedTaskCount);
+		}
+
+		chrono::nanoseconds ThreadPool::GetMaxWaitTime(const TaskPriority& priority) const
+		{
+			return chrono::nanoseconds(laneMaxWaitTime_[priority].load());
+		}
+
+		unsigned long long ThreadPool::GetStolenTaskCount() const
+		{
+			return stolenTaskCount_.load();
+		}
+
+		unsigned long long ThreadPool::GetSkippedTaskCount() const
+		{
+			return skippedTaskCount_.load();
+		}
+
+		wstring ThreadPool::GetName() const
+		{
+			return name_;
+		}
+
+		bool ThreadPool::IsCurrentWorker() const
+		{
+			return currentPool == this;
+		}
+
+		bool ThreadPool::IsStopped() const
+		{
+			return stop_.load();
+		}
+
+		unsigned int ThreadPool::GetPoolSize() const
+		{
+			return poolSize_;
+		}
+
+		unsigned int ThreadPool::GetMinPoolSize() const
+		{
+			return minPoolSize_;
+		}
+
+		unsigned int ThreadPool::GetMaxPoolSize() const
+		{
+			return maxPoolSize_;
+		}
+
+		unsigned long long ThreadPool::GetStartedWorkerCount() const
+		{
+			return startedWorkerCount_.load();
+		}
+
+		unsigned long long ThreadPool::GetRetiredWorkerCount() const
+		{
+			return retiredWorkerCount_.load();
+		}
+
+		unsigned int ThreadPool::GetBlockedWorkerCount() const
+		{
+			return blockedWorkerCount_.load();
+		}
+
+		unsigned long long ThreadPool::GetCompensatingWorkerCount() const
+		{
+			return compensatingWorkerCount_.load();
+		}
+
+		ThreadPoolMode ThreadPool::GetMode() const
+		{
+			return mode_;
+		}
+
+		DeadlinePolicy ThreadPool::GetDeadlinePolicy() const
+		{
+			return deadlinePolicy_;
+		}
+
+		unsigned long long ThreadPool::GetDeadlineHitCount() const
+		{
+			return deadlineHitCount_.load();
+		}
+
+		unsigned long long ThreadPool::GetDeadlineMissCount() const
+		{
+			return deadlineMissCount_.load();
+		}
+
+		unsigned long long ThreadPool::GetDeadlineShedCount() const
+		{
+			return deadlineShedCount_.load();
+		}
+
+		PlacementPolicy ThreadPool::GetPlacementPolicy() const
+		{
+			return placement_.policy_;
+		}
+
+		unsigned long long ThreadPool::GetUnpinnedWorkerCount() const
+		{
+			return unpinnedWorkerCount_.load();
+		}
+
+		vector<unsigned int> ThreadPool::GetNodes() const
+		{
+			return nodes_;
 		}
 	}
 }
\ No newline at end of file
@@ -1,42 +1,516 @@
 #pragma once
+#include "BoundedQueue.h"
+#include "SmallFunction.h"
+#include "TaskHistory.h"
+#include "LatencyHistogram.h"
 
 namespace utils
 {
 	namespace thread_management
 	{
+		enum ThreadPoolMode
+		{
+			//All workers take tasks from the shared intake queue in FIFO order.
+			SharedQueue,
+			//Each worker owns a deque, pushes and pops its own end (LIFO) and steals from the other end (FIFO) of its peers when idle.
+			WorkStealing,
+			//Like SharedQueue, but the tasks with a deadline wait in a separate queue and are dispatched ahead of the lanes, earliest deadline first.
+			//Tasks without a deadline and submitted calls take the SharedQueue path unchanged.
+			EarliestDeadlineFirst
+		};
+
+		//What an EarliestDeadlineFirst pool does with a task whose deadline already passed when it comes up for dispatch.
+		enum DeadlinePolicy
+		{
+			//Run it in deadline order like the others.
+			RunLate,
+			//Drop it without running it, its state becomes Expired.
+			ShedLate,
+			//Run it only once no task that can still make its deadline is waiting.
+			DeprioritizeLate
+		};
+
+		//Where the workers run. Every policy but NoPlacement pins the workers and gives each NUMA node its own intake queues:
+		//a worker drains the queues of its node before the others', and a task goes to the queues of the node it is enqueued from.
+		enum PlacementPolicy
+		{
+			//Workers float across the machine and share one set of intake queues.
+			NoPlacement,
+			//Pin worker i to the i-th logical processor, filling a node before moving to the next one.
+			Compact,
+			//Pin the workers to one processor of each node in turn.
+			Scatter,
+			//Pin each worker to all processors of one node in turn, making one sub-pool per node.
+			PerNode,
+			//Pin worker i to cpus_[i % cpus_.size()].
+			CpuList
+		};
+
+		struct WorkerPlacement
+		{
+			WorkerPlacement()
+				: policy_(NoPlacement)
+			{}
+
+			//Processors are numbered group * 64 + number within the group, the plain processor number on machines with up to 64 of them.
+			explicit WorkerPlacement(const PlacementPolicy& policy, const std::vector<unsigned int>& cpus = std::vector<unsigned int>())
+				: policy_(policy),
+				cpus_(cpus)
+			{}
+
+			PlacementPolicy policy_;
+			std::vector<unsigned int> cpus_;
+		};
+
+		//Unit of work carried by the pool's queues, either a Task or a callable handed to Submit.
+		struct WorkItem
+		{
+			WorkItem()
+				: priority_(Normal)
+			{}
+
+			WorkItem(const std::shared_ptr<Task>& pTask, const TaskPriority& priority, const std::chrono::steady_clock::time_point& enqueueTime)
+				: pTask_(pTask),
+				enqueueTime_(enqueueTime),
+				priority_(priority)
+			{}
+
+			WorkItem(SmallFunction&& function, const TaskPriority& priority)
+				: function_(std::move(function)),
+				priority_(priority)
+			{}
+
+			WorkItem(WorkItem&& rhs)
+				: pTask_(std::move(rhs.pTask_)),
+				function_(std::move(rhs.function_)),
+				enqueueTime_(rhs.enqueueTime_),
+				priority_(rhs.priority_)
+			{}
+
+			WorkItem& operator=(WorkItem&& rhs)
+			{
+				pTask_ = std::move(rhs.pTask_);
+				function_ = std::move(rhs.function_);
+				enqueueTime_ = rhs.enqueueTime_;
+				priority_ = rhs.priority_;
+				return *this;
+			}
+
+			std::shared_ptr<Task> pTask_;
+			SmallFunction function_;
+			std::chrono::steady_clock::time_point enqueueTime_;
+			TaskPriority priority_;
+		};
+
+		//Callable stored in a WorkItem by Submit, it runs the function and hands the result or the exception to the future.
+		template <typename TResult, typename TFunction>
+		class SubmitCall
+		{
+		public:
+			explicit SubmitCall(TFunction&& function)
+				: function_(std::move(function))
+			{}
+
+			SubmitCall(SubmitCall&& rhs)
+				: function_(std::move(rhs.function_)),
+				promise_(std::move(rhs.promise_))
+			{}
+
+			std::future<TResult> GetFuture()
+			{
+				return promise_.get_future();
+			}
+
+			void operator()()
+			{
+				try
+				{
+					SetResult(promise_, function_);
+				}
+				catch (...)
+				{
+					promise_.set_exception(std::current_exception());
+				}
+			}
+
+		private:
+			template <typename TValue>
+			static void SetResult(std::promise<TValue>& promise, TFunction& function)
+			{
+				promise.set_value(function());
+			}
+
+			static void SetResult(std::promise<void>& promise, TFunction& function)
+			{
+				function();
+				promise.set_value();
+			}
+
+			TFunction function_;
+			std::promise<TResult> promise_;
+		};
+
+		//Callable type and result type of Submit(function, args...), the arguments are bound by value.
+		template <typename F, typename... TArgs>
+		struct SubmitTraits
+		{
+			typedef typename std::decay<decltype(std::bind(std::declval<F>(), std::declval<TArgs>()...))>::type Function;
+			typedef decltype(std::declval<Function&>()()) Result;
+
+			static Function Bind(F&& function, TArgs&&... args)
+			{
+				return std::bind(std::forward<F>(function), std::forward<TArgs>(args)...);
+			}
+		};
+
+		template <typename F>
+		struct SubmitTraits<F>
+		{
+			typedef typename std::decay<F>::type Function;
+			typedef decltype(std::declval<Function&>()()) Result;
+
+			static Function Bind(F&& function)
+			{
+				return Function(std::forward<F>(function));
+			}
+		};
+
+		//Entry of the deadline queue of an EarliestDeadlineFirst pool, sequence_ keeps equal deadlines in FIFO order.
+		struct DeadlineItem
+		{
+			DeadlineItem(const std::chrono::steady_clock::time_point& deadline, const unsigned long long& sequence, WorkItem&& item)
+				: deadline_(deadline),
+				sequence_(sequence),
+				item_(std::move(item))
+			{}
+
+			DeadlineItem(DeadlineItem&& rhs)
+				: deadline_(rhs.deadline_),
+				sequence_(rhs.sequence_),
+				item_(std::move(rhs.item_))
+			{}
+
+			DeadlineItem& operator=(DeadlineItem&& rhs)
+			{
+				deadline_ = rhs.deadline_;
+				sequence_ = rhs.sequence_;
+				item_ = std::move(rhs.item_);
+				return *this;
+			}
+
+			std::chrono::steady_clock::time_point deadline_;
+			unsigned long long sequence_;
+			WorkItem item_;
+		};
+
+		//Orders a heap of DeadlineItem earliest first.
+		struct DeadlineItemSorter
+		{
+			bool operator()(const DeadlineItem& left, const DeadlineItem& right) const
+			{
+				return left.deadline_ > right.deadline_ || (left.deadline_ == right.deadline_ && left.sequence_ > right.sequence_);
+			}
+		};
+
+		struct WorkerQueue
+		{
+			WorkerQueue() : size_(0) {}
+
+			std::mutex mutex_;
+			std::deque<WorkItem> tasks_;
+			//Mirrors tasks_.size() so that thieves can skip empty peers without taking the lock.
+			std::atomic<size_t> size_;
+		};
+
+		//Elastic sizing of a pool: run minPoolSize_ workers, add one more, up to maxPoolSize_, when tasks keep waiting longer than queueWaitThreshold_ in the queue,
+		//and retire a worker that stayed idle for keepAlive_ while more than minPoolSize_ are running.
+		//The default policy is disabled and the pool keeps a fixed number of workers.
+		struct ElasticPolicy
+		{
+			ElasticPolicy()
+				: minPoolSize_(0),
+				maxPoolSize_(0),
+				keepAlive_(std::chrono::seconds(60)),
+				queueWaitThreshold_(std::chrono::milliseconds(10))
+			{}
+
+			ElasticPolicy(const unsigned int& minPoolSize, const unsigned int& maxPoolSize, const std::chrono::steady_clock::duration& keepAlive = std::chrono::seconds(60), const std::chrono::steady_clock::duration& queueWaitThreshold = std::chrono::milliseconds(10))
+				: minPoolSize_(minPoolSize),
+				maxPoolSize_(maxPoolSize),
+				keepAlive_(keepAlive),
+				queueWaitThreshold_(queueWaitThreshold)
+			{}
+
+			bool IsEnabled() const
+			{
+				return maxPoolSize_ > 0;
+			}
+
+			unsigned int minPoolSize_;
+			unsigned int maxPoolSize_;
+			std::chrono::steady_clock::duration keepAlive_;
+			std::chrono::steady_clock::duration queueWaitThreshold_;
+		};
+
+#ifdef __cpp_impl_coroutine
+		class ScheduleAwaiter;
+#endif
+
 		class ThreadPool
 		{
 		public:
-			//by default, keep last 1,000 executed tasks to be queryable.
+			//by default, keep last 10,000 executed tasks and 1,000 exception tasks to be queryable, split evenly across the workers.
 			//thread::hardware_concurrency();
-			ThreadPool(unsigned int poolSize = std::thread::hardware_concurrency(), const std::wstring& name = L"defaultThreadPool", const unsigned int& maxQueryableExecutedTaskSize = 10000, const unsigned int& maxPendingTaskSize = 1000000, const int& priority = THREAD_PRIORITY_NORMAL);
+			//An enabled elasticPolicy replaces poolSize, the pool then starts with elasticPolicy.minPoolSize_ workers.
+			//Up to maxCompensatingWorkerSize workers are started beyond the maximum to stand in for workers blocked in a BlockingRegion.
+			//intakeCapacity is rounded up to a power of two. Its slots are allocated up front, one ring per TaskPriority lane and NUMA node:
+			//every unit costs about sizeof(WorkItem) + 8 bytes times TaskPriorityCount per node, some 360 bytes on x64.
+			//A larger capacity absorbs longer bursts before producers wait for room.
+			ThreadPool(unsigned int poolSize = std::thread::hardware_concurrency(), const std::wstring& name = L"defaultThreadPool", const unsigned int& maxQueryableExecutedTaskSize = 10000, const unsigned int& maxPendingTaskSize = 1000000, const int& priority = THREAD_PRIORITY_NORMAL, const ThreadPoolMode& mode = SharedQueue, const unsigned int& intakeCapacity = 1024, const ElasticPolicy& elasticPolicy = ElasticPolicy(), const WorkerPlacement& placement = WorkerPlacement(), const unsigned int& maxCompensatingWorkerSize = 64, const DeadlinePolicy& deadlinePolicy = RunLate);
 			~ThreadPool();
 
+			//Start the minimum workers and return without waiting for them to be scheduled, tasks enqueued meanwhile wait in the queues.
 			void Setup();
-			bool Enqueue(std::shared_ptr<Task> task);
+			//Submitted tasks go through one lock-free intake queue of intakeCapacity slots per TaskPriority lane.
+			//Workers drain the lanes in priority order, but every few dispatches a lower lane goes first so that it cannot starve.
+			//In WorkStealing mode a Normal task enqueued from one of this pool's workers goes to that worker's own deque instead,
+			//so tasks are not dispatched in strict FIFO order in that mode.
+
+			//node is the NUMA node whose queues receive the task when the pool has a placement policy,
+			//AnyNode picks the node of the calling thread. It is ignored without placement.
+			static const int AnyNode = -1;
+
+			//Return false right away when the intake queue is full or more than maxPendingTaskSize tasks are pending.
+			bool TryEnqueue(std::shared_ptr<Task> task, const int& node = AnyNode);
+			//Block until there is room for the task, return false only if the pool is stopped.
+			//Called from a task running on this pool, the task is run inline rather than having the worker wait on itself.
+			bool Enqueue(std::shared_ptr<Task> task, const int& node = AnyNode);
+			//Block up to timeout for room, return false if the task could not be enqueued in time.
+			bool EnqueueFor(std::shared_ptr<Task> task, const std::chrono::steady_clock::duration& timeout, const int& node = AnyNode);
+
+			//Publish the tasks with one reservation on the intake queue and one counter update, then wake min(published, idle workers) threads.
+			//Return the number of tasks enqueued. TryEnqueueBatch stops at the first task that does not fit, EnqueueBatch waits for room like Enqueue.
+			size_t TryEnqueueBatch(const std::vector<std::shared_ptr<Task>>& tasks);
+			size_t EnqueueBatch(const std::vector<std::shared_ptr<Task>>& tasks);
+			size_t EnqueueBatch(const std::vector<std::function<void()>>& actions, const std::string& name = "");
+
+			template <typename TIterator>
+			size_t EnqueueBatch(TIterator first, TIterator last)
+			{
+				return EnqueueBatch(std::vector<std::shared_ptr<Task>>(first, last));
+			}
+
+			//Run function(args...) on the pool and return a future for its result or its exception.
+			//The call is stored in place in the queue, a lambda capturing up to a few pointers does not allocate beyond the future's shared state.
+			//Like Enqueue, wait for room when the pool is full. If the pool is stopped the future reports a broken promise.
+			template <typename F, typename... TArgs>
+			std::future<typename SubmitTraits<F, TArgs...>::Result> Submit(F&& function, TArgs&&... args)
+			{
+				return SubmitWithPriority(Normal, std::forward<F>(function), std::forward<TArgs>(args)...);
+			}
+
+			template <typename F, typename... TArgs>
+			std::future<typename SubmitTraits<F, TArgs...>::Result> SubmitWithPriority(const TaskPriority& priority, F&& function, TArgs&&... args)
+			{
+				typedef SubmitTraits<F, TArgs...> Traits;
+
+				SubmitCall<typename Traits::Result, typename Traits::Function> call(Traits::Bind(std::forward<F>(function), std::forward<TArgs>(args)...));
+				auto future = call.GetFuture();
+				WorkItem item(SmallFunction(std::move(call)), priority);
+				EnqueueItem(item, ResolveNode(AnyNode));
+				return future;
+			}
+
+			//Run function on the pool without a future, for callers that report completion themselves.
+			//Like Enqueue, wait for room when the pool is full. Return false if the pool is stopped.
+			template <typename F>
+			bool Post(F&& function, const TaskPriority& priority = Normal)
+			{
+				WorkItem item(SmallFunction(std::forward<F>(function)), priority);
+				return EnqueueItem(item, ResolveNode(AnyNode));
+			}
+
+			//Like Post, but return false right away when the pool is full.
+			template <typename F>
+			bool TryPost(F&& function, const TaskPriority& priority = Normal)
+			{
+				WorkItem item(SmallFunction(std::forward<F>(function)), priority);
+				return EnqueueItem(item, ResolveNode(AnyNode), std::chrono::steady_clock::duration::zero());
+			}
+
+			//Declare the calling thread blocked (disk, network, lock, sleep) for the lifetime of the region.
+			//In a task running on a pool with no idle worker, the pool starts a compensating worker so that the CPU-bound tasks keep their workers.
+			//Once the region ends, the workers beyond the pool's size retire as soon as they have nothing left in hand.
+			//Outside a pool's worker, or nested in another region, it does nothing. A task marked with Task::SetBlocking runs in one.
+			class BlockingRegion
+			{
+			public:
+				BlockingRegion();
+				~BlockingRegion();
+
+				BlockingRegion& operator=(const BlockingRegion& rhs) = delete;
+				BlockingRegion(const BlockingRegion& rhs) = delete;
+
+			private:
+				ThreadPool* pPool_;
+			};
+
+#ifdef __cpp_impl_coroutine
+			//co_await pool.Schedule() resumes the coroutine on a worker of this pool, see Coroutine.h.
+			ScheduleAwaiter Schedule(const TaskPriority& priority = Normal);
+#endif
+
 			std::wstring GetName() const;
+			//The calling thread is one of this pool's workers
+			bool IsCurrentWorker() const;
+			bool IsStopped() const;
+			//Number of running workers, between GetMinPoolSize() and GetMaxPoolSize() plus the compensating ones.
 			unsigned int GetPoolSize() const;
+			unsigned int GetMinPoolSize() const;
+			unsigned int GetMaxPoolSize() const;
+			unsigned long long GetStartedWorkerCount() const;
+			unsigned long long GetRetiredWorkerCount() const;
+			//Workers currently in a BlockingRegion, and workers started so far to compensate for them.
+			unsigned int GetBlockedWorkerCount() const;
+			unsigned long long GetCompensatingWorkerCount() const;
+			//Policy in effect, NoPlacement when the processor topology could not be read and the workers float.
+			PlacementPolicy GetPlacementPolicy() const;
+			//Workers of a pool with placement that were started floating: the system refused to pin them, or CpuList named no known processor.
+			//They still drain the queues of their node first.
+			unsigned long long GetUnpinnedWorkerCount() const;
+			//NUMA nodes with their own intake queues, a single entry without placement.
+			std::vector<unsigned int> GetNodes() const;
+			ThreadPoolMode GetMode() const;
+			DeadlinePolicy GetDeadlinePolicy() const;
+			//Tasks with a deadline that completed in time, that completed late or threw after it, and that were shed without running.
+			unsigned long long GetDeadlineHitCount() const;
+			unsigned long long GetDeadlineMissCount() const;
+			unsigned long long GetDeadlineShedCount() const;
 			unsigned long long GetExecutedTaskCount() const;
 			unsigned long long GetEnqueuedTaskCount() const;
 			unsigned long long GetPendingTaskCount() const;
+			//Per lane: tasks waiting in the lane, tasks taken out of it and the average/max time they waited there.
+			unsigned long long GetPendingTaskCount(const TaskPriority& priority) const;
+			unsigned long long GetDispatchedTaskCount(const TaskPriority& priority) const;
+			std::chrono::nanoseconds GetAverageWaitTime(const TaskPriority& priority) const;
+			std::chrono::nanoseconds GetMaxWaitTime(const TaskPriority& priority) const;
+			unsigned long long GetStolenTaskCount() const;
+			//Tasks cancelled through their token while pending, they were taken out of the queue and dropped without running.
+			//Cancelling does not free the queue: a cancelled task keeps its intake slot and counts against maxPendingTaskSize until a worker reaches it,
+			//so a burst of cancellations can still make Enqueue block or TryEnqueue fail.
+			unsigned long long GetSkippedTaskCount() const;
 			//std::vector<std::shared_ptr<Task>> GetPendingTasks() const;
-			std::vector<std::shared_ptr<Task>> GetExceptionTasks() const;
-			std::vector<std::shared_ptr<Task>> GetExecutedTasks() const;
+			//Merge the per worker histories, oldest first. Use Task::GetNameById to resolve the names.
+			std::vector<TaskRecord> GetExceptionTasks() const;
+			std::vector<TaskRecord> GetExecutedTasks() const;
+			//Queue wait and run time histograms of the tasks executed since the last ResetLatency, for the pool, one worker slot or every task name.
+			//Submitted calls and tasks without a name only count in the pool and worker histograms.
+			LatencyReport GetLatency() const;
+			LatencyReport GetWorkerLatency(const unsigned int& index) const;
+			std::unordered_map<std::string, LatencyReport> GetLatencyByName() const;
+			//Start the histograms over, each worker clears its own on its next task.
+			void ResetLatency();
 
 			//Wait for all running tasks to complete and then quit the worker threads.
 			void Stop();
 
 		protected:
+			//Start a worker in the slot, workersMutex_ must be held.
+			void StartWorker(unsigned int index);
+			//Start a worker in a free slot if no worker is idle and the pool is below its maximum, not counting the blocked workers.
+			bool TryAddWorker();
+			//Free the slot of an idle worker if the pool is above its minimum, the worker must then return.
+			bool TryRetireWorker(unsigned int index);
+			//More workers run than the maximum, not counting the blocked ones: a compensating worker is no longer needed.
+			bool HasSurplusWorker() const;
+			//Free the slot of a worker with no local work if the pool has a surplus worker, the worker must then return.
+			bool TryRetireSurplusWorker(unsigned int index);
+			void EnterBlocking();
+			void LeaveBlocking();
+			void RunWorker(unsigned int index);
+			bool TryDequeue(unsigned int index, unsigned long long dispatchCount, WorkItem& item);
+			bool TryDequeueLane(unsigned int index, const TaskPriority& priority, WorkItem& item);
+			//Take the earliest deadline task, shedding or setting aside the late ones on the way as the policy says.
+			bool TryDequeueDeadline(WorkItem& item);
+			//The task goes to the deadline queue rather than to a lane.
+			bool IsDeadlineTask(const std::shared_ptr<Task>& pTask) const;
+			size_t PublishDeadline(const std::shared_ptr<Task>* pTasks, size_t count);
+			size_t PublishTasks(const std::shared_ptr<Task>* pTasks, size_t count, const unsigned int& node);
+			//Take from the intake queues of the worker's node first, then from the other nodes'.
+			bool TryDequeueIntake(unsigned int index, const TaskPriority& priority, WorkItem& item);
+			//Return how long the item waited in its queue.
+			std::chrono::steady_clock::duration RecordDispatch(const WorkItem& item, const std::chrono::steady_clock::time_point& dispatchTime);
+			bool HasQueuedTask() const;
+			size_t TryEnqueueBatch(const std::shared_ptr<Task>* pTasks, size_t count, const unsigned int& node);
+			//Blocking publish of a single item shared by Enqueue, EnqueueFor and Submit, the item is left untouched when it returns false.
+			bool EnqueueItem(WorkItem& item, const unsigned int& node, const std::chrono::steady_clock::duration& timeout = std::chrono::steady_clock::duration::max());
+			//priorityOf(i) gives the lane of the i-th item and makeItem(i) builds it once it has room.
+			template <typename TPriorityOf, typename TMakeItem>
+			size_t PublishBatch(size_t count, const unsigned int& node, TPriorityOf priorityOf, TMakeItem makeItem);
+			template <typename TMakeItem>
+			size_t PublishRun(size_t first, size_t count, const unsigned int& node, const TaskPriority& priority, TMakeItem& makeItem);
+			//Map a NUMA node number or AnyNode to the index of its intake queues.
+			unsigned int ResolveNode(const int& node) const;
+			BoundedQueue<WorkItem>& GetIntakeQueue(const unsigned int& node, const TaskPriority& priority) const;
+			//Compute the node and the affinity of every worker slot.
+			void SetupPlacement();
+			void WakeWorkers(size_t count);
+			bool TryPopLocal(unsigned int index, WorkItem& item);
+			bool TrySteal(unsigned int index, WorkItem& item);
+			//dispatchTime ends the queue wait and starts the run time of the item.
+			void Execute(unsigned int index, WorkItem& item, const std::chrono::steady_clock::time_point& dispatchTime);
+			//A pending slot was freed, wake a producer blocked waiting for one.
+			void NotifyProducer();
+			std::vector<TaskRecord> MergeHistories(const std::vector<std::shared_ptr<TaskHistory>>& histories, const size_t& maxSize) const;
+
 			std::mutex queueMutex_;
-			mutable SRWLOCK srwLock_;
 			int priority_;
+			ThreadPoolMode mode_;
 
 			std::condition_variable cdv_;
+			//Producers blocked in Enqueue/EnqueueFor park here until a worker frees room.
+			std::mutex spaceMutex_;
+			std::condition_variable spaceCdv_;
+			//Guards the worker slots: threads_ and activeWorkers_.
+			std::mutex workersMutex_;
+			//One slot per potential worker, a retired worker's thread is joined when its slot is reused or the pool stops.
 			std::vector<std::shared_ptr<std::thread>> threads_;
+			std::vector<bool> activeWorkers_;
+			ElasticPolicy elasticPolicy_;
+			unsigned int minPoolSize_;
+			unsigned int maxPoolSize_;
+			unsigned int maxCompensatingWorkerSize_;
+			//maxPoolSize_ + maxCompensatingWorkerSize_, the size of every per worker vector
+			unsigned int workerSlotCount_;
+			//One past the highest slot a worker ever started in, the idle scans of the worker deques stop there
+			std::atomic<unsigned int> startedSlotCount_;
+
+			//Deadline heap and the tasks set aside by DeprioritizeLate, both guarded by deadlineMutex_
+			std::mutex deadlineMutex_;
+			std::vector<DeadlineItem> deadlineQueue_;
+			std::deque<WorkItem> lateItems_;
+			unsigned long long deadlineSequence_;
+			//Tasks in deadlineQueue_ and lateItems_, workers only take deadlineMutex_ when it is not zero
+			std::atomic<size_t> deadlineTaskCount_;
+			DeadlinePolicy deadlinePolicy_;
 
-			std::deque<std::shared_ptr<Task>> taskQueue_;
-			std::deque<std::shared_ptr<Task>> executedTasks_;
-			std::deque<std::shared_ptr<Task>> exceptionTasks_;
+			//One intake queue per node and TaskPriority, the queues of node n start at n * TaskPriorityCount
+			std::vector<std::shared_ptr<BoundedQueue<WorkItem>>> taskQueues_;
+			WorkerPlacement placement_;
+			//NUMA node numbers, indexed by the node index used for the queues
+			std::vector<unsigned int> nodes_;
+			//Node index of every logical processor, indexed by group * 64 + number
+			std::vector<unsigned int> processorNodes_;
+			//Node index and affinity of every worker slot, an empty mask leaves the worker floating
+			std::vector<unsigned int> workerNodes_;
+			std::vector<GROUP_AFFINITY> workerAffinities_;
+			std::vector<std::shared_ptr<WorkerQueue>> workerQueues_;
+			//One history ring per worker slot
+			std::vector<std::shared_ptr<TaskHistory>> executedTasks_;
+			std::vector<std::shared_ptr<TaskHistory>> exceptionTasks_;
+			//One latency recorder per worker slot, the histograms of the current epoch are the live ones
+			std::vector<std::shared_ptr<LatencyRecorder>> latencies_;
+			std::atomic<unsigned long long> latencyEpoch_;
 			std::wstring name_;
 			unsigned int maxQueryableExecutedTaskSize_;
 			//unsigned int maxEnqueableTaskSize_;
@@ -45,7 +519,24 @@ namespace utils
 			std::atomic<bool> stop_;
 			std::atomic<unsigned long long> enqueuedTaskCount_;
 			std::atomic<unsigned long long> executedTaskCount_;
-			std::atomic<unsigned int> readyThreadCount_;
+			std::atomic<unsigned long long> stolenTaskCount_;
+			std::atomic<unsigned long long> skippedTaskCount_;
+			std::atomic<unsigned long long> startedWorkerCount_;
+			std::atomic<unsigned long long> retiredWorkerCount_;
+			std::atomic<unsigned int> blockedWorkerCount_;
+			std::atomic<unsigned long long> compensatingWorkerCount_;
+			std::atomic<unsigned long long> unpinnedWorkerCount_;
+			std::atomic<unsigned long long> deadlineHitCount_;
+			std::atomic<unsigned long long> deadlineMissCount_;
+			std::atomic<unsigned long long> deadlineShedCount_;
+			//Number of workers parked on cdv_, producers only take queueMutex_ when it is not zero.
+			std::atomic<unsigned int> idleThreadCount_;
+			//Number of producers parked on spaceCdv_, workers only take spaceMutex_ when it is not zero.
+			std::atomic<unsigned int> blockedProducerCount_;
+			std::atomic<unsigned long long> laneEnqueuedTaskCount_[TaskPriorityCount];
+			std::atomic<unsigned long long> laneDispatchedTaskCount_[TaskPriorityCount];
+			std::atomic<unsigned long long> laneTotalWaitTime_[TaskPriorityCount];
+			std::atomic<unsigned long long> laneMaxWaitTime_[TaskPriorityCount];
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,513 @@
+#include "stdafx.h"
+#include "TimerQueue.h"
+
+using namespace std;
+
+namespace utils
+{
+	namespace thread_management
+	{
+		TimerQueue::TimerQueue()
+			:
+			freeNode_(NoNode),
+			size_(0)
+		{
+		}
+
+		unsigned int TimerQueue::Allocate()
+		{
+			auto node = freeNode_;
+			if (node != NoNode)
+			{
+				freeNode_ = nodes_[node].next_;
+				return node;
+			}
+
+			TimerNode timerNode;
+			timerNode.generation_ = 1;
+			timerNode.state_ = FreeNode;
+			nodes_.push_back(timerNode);
+			return static_cast<unsigned int>(nodes_.size() - 1);
+		}
+
+		void TimerQueue::Free(const unsigned int& node)
+		{
+			auto& timerNode = nodes_[node];
+
+			//Release the task now, the entry may stay unused for long
+			timerNode.pTask_ = nullptr;
+			timerNode.state_ = FreeNode;
+			if (++timerNode.generation_ == 0)
+			{
+				timerNode.generation_ = 1;
+			}
+			timerNode.next_ = freeNode_;
+			freeNode_ = node;
+		}
+
+		unsigned int TimerQueue::Find(const TimerId& timerId) const
+		{
+			auto node = static_cast<unsigned int>(timerId & 0xFFFFFFFF);
+			if (node >= nodes_.size() || nodes_[node].generation_ != static_cast<unsigned int>(timerId >> 32) || nodes_[node].state_ == FreeNode)
+			{
+				return NoNode;
+			}
+
+			return node;
+		}
+
+		TimerId TimerQueue::GetId(const unsigned int& node) const
+		{
+			return (static_cast<TimerId>(nodes_[node].generation_) << 32) | node;
+		}
+
+		TimerId TimerQueue::Push(const TimeAndIntervalAndTask& timer)
+		{
+			auto node = Allocate();
+			auto& timerNode = nodes_[node];
+			timerNode.pTask_ = timer.pTask_;
+			timerNode.recurringInterval_ = timer.recurringInterval_;
+			timerNode.startTime_ = timer.startTime_;
+			timerNode.slack_ = timer.slack_;
+			timerNode.dueTime_ = GetCoalescedTime(timer.startTime_, timer.slack_);
+			timerNode.occurrenceCount_ = timer.occurrenceCount_;
+			timerNode.state_ = QueuedNode;
+			Link(node);
+			size_++;
+			return GetId(node);
+		}
+
+		void TimerQueue::PopDue(const chrono::steady_clock::time_point& now, vector<TimeAndIntervalAndTask>& due)
+		{
+			dueNodes_.clear();
+			TakeDue(now, dueNodes_);
+			for (auto node : dueNodes_)
+			{
+				auto& timerNode = nodes_[node];
+				timerNode.state_ = DueNode;
+				size_--;
+				due.push_back(TimeAndIntervalAndTask(timerNode.pTask_, timerNode.recurringInterval_, timerNode.startTime_, GetId(node), timerNode.occurrenceCount_, timerNode.slack_));
+			}
+		}
+
+		bool TimerQueue::Rearm(const TimeAndIntervalAndTask& timer)
+		{
+			auto node = Find(timer.timerId_);
+			if (node == NoNode || nodes_[node].state_ == QueuedNode)
+			{
+				return false;
+			}
+
+			auto& timerNode = nodes_[node];
+			if (timerNode.state_ == CancelledNode)
+			{
+				Free(node);
+				return false;
+			}
+
+			timerNode.pTask_ = timer.pTask_;
+			timerNode.recurringInterval_ = timer.recurringInterval_;
+			timerNode.startTime_ = timer.startTime_;
+			timerNode.slack_ = timer.slack_;
+			timerNode.dueTime_ = GetCoalescedTime(timer.startTime_, timer.slack_);
+			timerNode.occurrenceCount_ = timer.occurrenceCount_;
+			timerNode.state_ = QueuedNode;
+			Link(node);
+			size_++;
+			return true;
+		}
+
+		void TimerQueue::Release(const TimerId& timerId)
+		{
+			auto node = Find(timerId);
+			if (node != NoNode && nodes_[node].state_ != QueuedNode)
+			{
+				Free(node);
+			}
+		}
+
+		bool TimerQueue::IsLive(const TimerId& timerId) const
+		{
+			auto node = Find(timerId);
+			return node != NoNode && nodes_[node].state_ != CancelledNode;
+		}
+
+		TimeAndIntervalAndTask TimerQueue::Cancel(const TimerId& timerId)
+		{
+			TimeAndIntervalAndTask timer(nullptr, chrono::system_clock::duration(0), chrono::steady_clock::time_point());
+			auto node = Find(timerId);
+			if (node == NoNode)
+			{
+				return timer;
+			}
+
+			auto& timerNode = nodes_[node];
+			if (timerNode.state_ == CancelledNode)
+			{
+				return timer;
+			}
+
+			timer = TimeAndIntervalAndTask(timerNode.pTask_, timerNode.recurringInterval_, timerNode.startTime_, timerId, timerNode.occurrenceCount_, timerNode.slack_);
+			if (timerNode.state_ == DueNode)
+			{
+				timerNode.state_ = CancelledNode;
+				return timer;
+			}
+
+			Unlink(node);
+			size_--;
+			Free(node);
+			return timer;
+		}
+
+		bool TimerQueue::Reschedule(const TimerId& timerId, const chrono::steady_clock::time_point& startTime)
+		{
+			auto node = Find(timerId);
+			if (node == NoNode || nodes_[node].state_ != QueuedNode)
+			{
+				return false;
+			}
+
+			Unlink(node);
+			nodes_[node].startTime_ = startTime;
+			nodes_[node].dueTime_ = GetCoalescedTime(startTime, nodes_[node].slack_);
+			Link(node);
+			return true;
+		}
+
+		bool TimerQueue::ChangeInterval(const TimerId& timerId, const chrono::system_clock::duration& recurringInterval)
+		{
+			auto node = Find(timerId);
+			if (node == NoNode || nodes_[node].state_ != QueuedNode)
+			{
+				return false;
+			}
+
+			nodes_[node].recurringInterval_ = recurringInterval;
+			return true;
+		}
+
+		size_t TimerQueue::GetSize() const
+		{
+			return size_;
+		}
+
+		chrono::steady_clock::time_point TimerQueue::GetCoalescedTime(const chrono::steady_clock::time_point& startTime, const chrono::steady_clock::duration& slack)
+		{
+			chrono::steady_clock::duration granularity = chrono::milliseconds(1);
+			if (slack < granularity)
+			{
+				return startTime;
+			}
+
+			while (granularity * 2 <= slack)
+			{
+				granularity *= 2;
+			}
+
+			auto remainder = startTime.time_since_epoch() % granularity;
+			if (remainder < chrono::steady_clock::duration(0))
+			{
+				remainder += granularity;
+			}
+
+			return remainder == chrono::steady_clock::duration(0) ? startTime : startTime + (granularity - remainder);
+		}
+
+		TimerHeap::TimerHeap()
+			:
+			staleCount_(0)
+		{
+		}
+
+		chrono::steady_clock::time_point TimerHeap::GetNextTime() const
+		{
+			return heap_.empty() ? chrono::steady_clock::time_point::max() : heap_.front().dueTime_;
+		}
+
+		void TimerHeap::Link(const unsigned int& node)
+		{
+			if (node >= versions_.size())
+			{
+				versions_.resize(node + 1, 0);
+			}
+
+			HeapEntry entry;
+			entry.dueTime_ = nodes_[node].dueTime_;
+			entry.node_ = node;
+			entry.version_ = versions_[node];
+			heap_.push_back(entry);
+			push_heap(heap_.begin(), heap_.end(), HeapEntrySorter());
+		}
+
+		void TimerHeap::Unlink(const unsigned int& node)
+		{
+			versions_[node]++;
+			staleCount_++;
+			DropStale();
+
+			//Rebuild once most of the heap is stale, which keeps the cost amortized O(1) per unlink
+			if (staleCount_ > heap_.size() / 2 && staleCount_ >= 64)
+			{
+				heap_.erase(remove_if(heap_.begin(), heap_.end(), [this](const HeapEntry& entry) { return IsStale(entry); }), heap_.end());
+				make_heap(heap_.begin(), heap_.end(), HeapEntrySorter());
+				staleCount_ = 0;
+			}
+		}
+
+		void TimerHeap::TakeDue(const chrono::steady_clock::time_point& now, vector<unsigned int>& due)
+		{
+			while (!heap_.empty() && heap_.front().dueTime_ <= now)
+			{
+				pop_heap(heap_.begin(), heap_.end(), HeapEntrySorter());
+				auto entry = heap_.back();
+				heap_.pop_back();
+				if (IsStale(entry))
+				{
+					staleCount_--;
+					continue;
+				}
+
+				due.push_back(entry.node_);
+			}
+
+			DropStale();
+		}
+
+		bool TimerHeap::IsStale(const HeapEntry& entry) const
+		{
+			return versions_[entry.node_] != entry.version_;
+		}
+
+		void TimerHeap::DropStale()
+		{
+			while (!heap_.empty() && IsStale(heap_.front()))
+			{
+				pop_heap(heap_.begin(), heap_.end(), HeapEntrySorter());
+				heap_.pop_back();
+				staleCount_--;
+			}
+		}
+
+		TimingWheel::TimingWheel(const chrono::steady_clock::duration& tick)
+			:
+			tick_(max(tick, chrono::steady_clock::duration(1))),
+			origin_(chrono::steady_clock::now()),
+			currentTick_(0),
+			slots_(LevelCount * SlotCount + 1, NoNode),
+			occupied_(LevelCount * WordsPerLevel, 0)
+		{
+		}
+
+		unsigned long long TimingWheel::GetTickAfter(const chrono::steady_clock::time_point& time) const
+		{
+			auto elapsed = (time - origin_).count();
+			if (elapsed <= 0)
+			{
+				return 0;
+			}
+
+			return static_cast<unsigned long long>((elapsed + tick_.count() - 1) / tick_.count());
+		}
+
+		chrono::steady_clock::time_point TimingWheel::GetTickTime(const unsigned long long& tick) const
+		{
+			return origin_ + tick_ * tick;
+		}
+
+		void TimingWheel::Link(const unsigned int& node)
+		{
+			//A timer already due fires on the next tick expired
+			auto tick = max(GetTickAfter(nodes_[node].dueTime_), currentTick_);
+			auto delta = tick - currentTick_;
+			for (unsigned int level = 0; level < LevelCount; level++)
+			{
+				if (delta < (1ULL << (SlotBits * (level + 1))))
+				{
+					LinkToSlot(node, level * SlotCount + static_cast<unsigned int>((tick >> (SlotBits * level)) & (SlotCount - 1)));
+					return;
+				}
+			}
+
+			LinkToSlot(node, OverflowSlot);
+		}
+
+		void TimingWheel::LinkToSlot(unsigned int node, unsigned int slot)
+		{
+			auto& timerNode = nodes_[node];
+			auto head = slots_[slot];
+			timerNode.slot_ = slot;
+			timerNode.previous_ = NoNode;
+			timerNode.next_ = head;
+			if (head != NoNode)
+			{
+				nodes_[head].previous_ = node;
+			}
+			slots_[slot] = node;
+
+			if (slot != OverflowSlot)
+			{
+				occupied_[slot / WordBits] |= 1u << (slot % WordBits);
+			}
+		}
+
+		void TimingWheel::Unlink(const unsigned int& node)
+		{
+			auto& timerNode = nodes_[node];
+			if (timerNode.previous_ != NoNode)
+			{
+				nodes_[timerNode.previous_].next_ = timerNode.next_;
+			}
+			else
+			{
+				slots_[timerNode.slot_] = timerNode.next_;
+			}
+
+			if (timerNode.next_ != NoNode)
+			{
+				nodes_[timerNode.next_].previous_ = timerNode.previous_;
+			}
+
+			if (slots_[timerNode.slot_] == NoNode && timerNode.slot_ != OverflowSlot)
+			{
+				occupied_[timerNode.slot_ / WordBits] &= ~(1u << (timerNode.slot_ % WordBits));
+			}
+		}
+
+		unsigned int TimingWheel::TakeSlot(unsigned int slot)
+		{
+			auto head = slots_[slot];
+			slots_[slot] = NoNode;
+			if (slot != OverflowSlot)
+			{
+				occupied_[slot / WordBits] &= ~(1u << (slot % WordBits));
+			}
+
+			return head;
+		}
+
+		void TimingWheel::Cascade()
+		{
+			//The overflow list once the last level wrapped around, then each level whose lower levels all wrapped around
+			if ((currentTick_ & ((1ULL << (SlotBits * LevelCount)) - 1)) == 0)
+			{
+				for (auto node = TakeSlot(OverflowSlot); node != NoNode;)
+				{
+					auto next = nodes_[node].next_;
+					Link(node);
+					node = next;
+				}
+			}
+
+			for (auto level = LevelCount - 1; level > 0; level--)
+			{
+				if ((currentTick_ & ((1ULL << (SlotBits * level)) - 1)) != 0)
+				{
+					continue;
+				}
+
+				auto slot = level * SlotCount + static_cast<unsigned int>((currentTick_ >> (SlotBits * level)) & (SlotCount - 1));
+				for (auto node = TakeSlot(slot); node != NoNode;)
+				{
+					auto next = nodes_[node].next_;
+					Link(node);
+					node = next;
+				}
+			}
+		}
+
+		void TimingWheel::TakeDue(const chrono::steady_clock::time_point& now, vector<unsigned int>& due)
+		{
+			if (now < origin_)
+			{
+				return;
+			}
+
+			//Expire every tick up to the last one started
+			auto lastTick = static_cast<unsigned long long>((now - origin_).count() / tick_.count());
+			auto firstDue = due.size();
+			while (currentTick_ <= lastTick)
+			{
+				if (due.size() - firstDue == GetSize())
+				{
+					//Every timer is taken
+					currentTick_ = lastTick + 1;
+					break;
+				}
+
+				auto index = static_cast<unsigned int>(currentTick_ & (SlotCount - 1));
+				if (index == 0)
+				{
+					Cascade();
+				}
+
+				for (auto node = TakeSlot(index); node != NoNode; node = nodes_[node].next_)
+				{
+					due.push_back(node);
+				}
+
+				//Skip the empty slots up to the next occupied one, or up to the wrap around where the higher levels cascade
+				auto skip = (index + 1 < SlotCount) ? FindOccupied(0, index + 1, SlotCount - index - 1) : 0;
+				currentTick_ = min(currentTick_ + 1 + skip, lastTick + 1);
+			}
+		}
+
+		unsigned int TimingWheel::FindOccupied(const unsigned int& level, const unsigned int& from, const unsigned int& count) const
+		{
+			unsigned int distance = 0;
+			while (distance < count)
+			{
+				auto slot = (from + distance) & (SlotCount - 1);
+				unsigned long bit;
+				if (_BitScanForward(&bit, static_cast<unsigned long>(occupied_[level * WordsPerLevel + slot / WordBits] >> (slot % WordBits))))
+				{
+					return min(distance + static_cast<unsigned int>(bit), count);
+				}
+
+				distance += WordBits - slot % WordBits;
+			}
+
+			return count;
+		}
+
+		chrono::steady_clock::time_point TimingWheel::GetNextTime() const
+		{
+			if (GetSize() == 0)
+			{
+				return chrono::steady_clock::time_point::max();
+			}
+
+			//A timer of the current level 0 window fires at its tick, otherwise wake up for the next cascade of an occupied slot
+			auto index = static_cast<unsigned int>(currentTick_ & (SlotCount - 1));
+			auto distance = FindOccupied(0, index, SlotCount - index);
+			if (distance < SlotCount - index)
+			{
+				return GetTickTime(currentTick_ + distance);
+			}
+
+			auto nextTick = numeric_limits<unsigned long long>::max();
+			for (unsigned int level = 1; level < LevelCount; level++)
+			{
+				//The slot holding currentTick_ was cascaded when the wheel entered it, it only holds timers one full turn ahead
+				auto base = currentTick_ >> (SlotBits * level);
+				auto offset = FindOccupied(level, static_cast<unsigned int>((base + 1) & (SlotCount - 1)), SlotCount);
+				if (offset < SlotCount)
+				{
+					nextTick = min(nextTick, (base + 1 + offset) << (SlotBits * level));
+				}
+			}
+
+			if (slots_[OverflowSlot] != NoNode)
+			{
+				nextTick = min(nextTick, ((currentTick_ >> (SlotBits * LevelCount)) + 1) << (SlotBits * LevelCount));
+			}
+
+			return GetTickTime(nextTick);
+		}
+
+		chrono::steady_clock::duration TimingWheel::GetTick() const
+		{
+			return tick_;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+#pragma once
+#include "Task.h"
+
+namespace utils
+{
+	namespace thread_management
+	{
+		//Identifies a queued timer, stays valid across the occurrences of a recurring timer until it is cancelled or released.
+		typedef unsigned long long TimerId;
+		const TimerId InvalidTimerId = 0;
+
+		struct TimeAndIntervalAndTask
+		{
+			TimeAndIntervalAndTask(std::shared_ptr<Task> pTask, const std::chrono::system_clock::duration& recurringInterval, const std::chrono::steady_clock::time_point& startTime, const TimerId& timerId = InvalidTimerId,
+				const unsigned long long& occurrenceCount = 0, const std::chrono::steady_clock::duration& slack = std::chrono::steady_clock::duration(0))
+				: pTask_(pTask),
+				recurringInterval_(recurringInterval),
+				startTime_(startTime),
+				timerId_(timerId),
+				occurrenceCount_(occurrenceCount),
+				slack_(slack)
+			{}		
+
+			std::shared_ptr<Task> pTask_;
+			std::chrono::system_clock::duration recurringInterval_;
+			std::chrono::steady_clock::time_point startTime_;			
+			TimerId timerId_;
+			//Occurrences handed to the pool so far, a recurring timer runs the same task every time
+			unsigned long long occurrenceCount_;
+			//How late after startTime_ the timer may fire, so that it shares its expiry with others, see TimerQueue::GetCoalescedTime
+			std::chrono::steady_clock::duration slack_;
+		};
+
+		struct TimeAndIntervalAndTaskSorter
+		{
+			bool operator()(const TimeAndIntervalAndTask& left, const TimeAndIntervalAndTask& right)
+			{
+				return left.startTime_ > right.startTime_;
+			}
+		};		
+
+		enum TimerQueueKind
+		{
+			//Binary heap: O(log n) push and pop, timers fire in exact start time order.
+			TimerHeapQueue,
+			//Hierarchical timing wheel: O(1) push, cancel and expiry, timers fire on the first tick at or after their start time.
+			TimingWheelQueue
+		};
+
+		//Pending timers of a Scheduler. Not thread safe, the Scheduler guards it with its lock.
+		//The timers are kept in one vector and linked by index, so that one is found from its id in O(1), and the entry of a released timer is reused by the next push.
+		//A timer handed out by PopDue keeps its entry until it is given back to Rearm or Release.
+		class TimerQueue
+		{
+		public:
+			TimerQueue();
+			virtual ~TimerQueue() {}
+
+			//Queue a new timer and return its id.
+			TimerId Push(const TimeAndIntervalAndTask& timer);
+			//Move the timers due at now to the end of due, with their ids.
+			void PopDue(const std::chrono::steady_clock::time_point& now, std::vector<TimeAndIntervalAndTask>& due);
+			//Queue again a timer handed out by PopDue, under its id, with the task and start time of timer.
+			//Return false if the timer was cancelled meanwhile, it is released then.
+			bool Rearm(const TimeAndIntervalAndTask& timer);
+			//Forget a timer handed out by PopDue, its id becomes invalid.
+			void Release(const TimerId& timerId);
+			//The id refers to a queued timer, or to one handed out by PopDue and not cancelled since.
+			bool IsLive(const TimerId& timerId) const;
+
+			//Remove a queued timer and return it, with a null task if the id is not live any more.
+			//A timer handed out by PopDue is only marked and returned, Rearm or Release then frees it.
+			TimeAndIntervalAndTask Cancel(const TimerId& timerId);
+			//Move a queued timer to startTime. Return false if the id is not queued any more.
+			bool Reschedule(const TimerId& timerId, const std::chrono::steady_clock::time_point& startTime);
+			//Interval of the next occurrences, 0 makes the timer fire only once more. Return false if the id is not queued any more.
+			bool ChangeInterval(const TimerId& timerId, const std::chrono::system_clock::duration& recurringInterval);
+
+			//When to call PopDue next, time_point::max() when the queue is empty.
+			//A TimingWheel may answer before its next timer is due when it only has to move far timers closer, PopDue then returns nothing.
+			virtual std::chrono::steady_clock::time_point GetNextTime() const = 0;
+			//Queued timers, those cancelled or handed out by PopDue excluded.
+			size_t GetSize() const;
+
+			//Time a timer with this slack expires at: startTime rounded up to the coarsest power of two of milliseconds not above the slack.
+			//The grid of a larger slack is part of those of the smaller ones, so timers of any slack and phase land on shared expiries.
+			static std::chrono::steady_clock::time_point GetCoalescedTime(const std::chrono::steady_clock::time_point& startTime, const std::chrono::steady_clock::duration& slack);
+
+		protected:
+			static const unsigned int NoNode = 0xFFFFFFFF;
+
+			enum TimerNodeState
+			{
+				FreeNode,
+				QueuedNode,
+				//Handed out by PopDue
+				DueNode,
+				//Cancelled while handed out
+				CancelledNode
+			};
+
+			struct TimerNode
+			{
+				std::shared_ptr<Task> pTask_;
+				std::chrono::system_clock::duration recurringInterval_;
+				std::chrono::steady_clock::time_point startTime_;
+				std::chrono::steady_clock::duration slack_;
+				//startTime_ coalesced with the slack, the queues order the nodes by it
+				std::chrono::steady_clock::time_point dueTime_;
+				unsigned long long occurrenceCount_;
+				//Links of the queue, free list included
+				unsigned int next_;
+				unsigned int previous_;
+				unsigned int slot_;
+				//Part of the id, bumped when the entry is released so that older ids miss
+				unsigned int generation_;
+				TimerNodeState state_;
+			};
+
+			//Link and unlink a node in the queue's own order
+			virtual void Link(const unsigned int& node) = 0;
+			virtual void Unlink(const unsigned int& node) = 0;
+			//Unlink the due nodes and append them to due
+			virtual void TakeDue(const std::chrono::steady_clock::time_point& now, std::vector<unsigned int>& due) = 0;
+
+			std::vector<TimerNode> nodes_;
+
+		private:
+			unsigned int Allocate();
+			void Free(const unsigned int& node);
+			//Node of a live id, NoNode otherwise
+			unsigned int Find(const TimerId& timerId) const;
+			TimerId GetId(const unsigned int& node) const;
+
+			unsigned int freeNode_;
+			size_t size_;
+			std::vector<unsigned int> dueNodes_;
+		};
+
+		//Binary heap: O(log n) push and pop, timers fire in exact start time order.
+		//Cancelled and moved timers leave their old heap entry behind, it is dropped when it reaches the top or when stale entries outnumber the live ones.
+		class TimerHeap : public TimerQueue
+		{
+		public:
+			TimerHeap();
+
+			std::chrono::steady_clock::time_point GetNextTime() const;
+
+		protected:
+			void Link(const unsigned int& node);
+			void Unlink(const unsigned int& node);
+			void TakeDue(const std::chrono::steady_clock::time_point& now, std::vector<unsigned int>& due);
+
+		private:
+			struct HeapEntry
+			{
+				std::chrono::steady_clock::time_point dueTime_;
+				unsigned int node_;
+				//Matches the node's version_ while the entry is live
+				unsigned int version_;
+			};
+
+			struct HeapEntrySorter
+			{
+				bool operator()(const HeapEntry& left, const HeapEntry& right) const
+				{
+					return left.dueTime_ > right.dueTime_;
+				}
+			};
+
+			bool IsStale(const HeapEntry& entry) const;
+			//Pop the stale entries off the top, so that the top is always live
+			void DropStale();
+
+			std::vector<HeapEntry> heap_;
+			//Per node, bumped whenever the node is unlinked
+			std::vector<unsigned int> versions_;
+			size_t staleCount_;
+		};
+
+		//LevelCount wheels of SlotCount slots: a slot of level k spans SlotCount^k ticks, so the wheels cover SlotCount^LevelCount ticks ahead
+		//(about 49 days with 1 ms ticks), later timers wait in an overflow list. A timer is linked in the slot of the lowest level its start tick fits in,
+		//and moved down a level each time the wheel below wraps around into its slot. Timers of the same tick fire in no particular order.
+		//Slots are doubly linked lists, so push, cancel and reschedule are O(1).
+		class TimingWheel : public TimerQueue
+		{
+		public:
+			explicit TimingWheel(const std::chrono::steady_clock::duration& tick = std::chrono::milliseconds(1));
+
+			std::chrono::steady_clock::time_point GetNextTime() const;
+			std::chrono::steady_clock::duration GetTick() const;
+
+		protected:
+			void Link(const unsigned int& node);
+			void Unlink(const unsigned int& node);
+			void TakeDue(const std::chrono::steady_clock::time_point& now, std::vector<unsigned int>& due);
+
+		private:
+			static const unsigned int SlotBits = 8;
+			static const unsigned int SlotCount = 1 << SlotBits;
+			static const unsigned int LevelCount = 4;
+			//Slot of the timers beyond the last level, they are placed again each time the last level wraps around
+			static const unsigned int OverflowSlot = LevelCount * SlotCount;
+			static const unsigned int WordBits = 32;
+			static const unsigned int WordsPerLevel = SlotCount / WordBits;
+
+			//First tick at or after time
+			unsigned long long GetTickAfter(const std::chrono::steady_clock::time_point& time) const;
+			std::chrono::steady_clock::time_point GetTickTime(const unsigned long long& tick) const;
+			void LinkToSlot(unsigned int node, unsigned int slot);
+			//Unlink the whole slot and return its first node
+			unsigned int TakeSlot(unsigned int slot);
+			//Place again the timers of the slots the wheels wrap into at currentTick_, from the highest level down.
+			void Cascade();
+			//Distance from slot from of the level to its next occupied slot within count slots, count when there is none.
+			unsigned int FindOccupied(const unsigned int& level, const unsigned int& from, const unsigned int& count) const;
+
+			std::chrono::steady_clock::duration tick_;
+			std::chrono::steady_clock::time_point origin_;
+			//Every tick before it was expired
+			unsigned long long currentTick_;
+			std::vector<unsigned int> slots_;
+			//One bit per slot with timers, OverflowSlot excluded
+			std::vector<unsigned int> occupied_;
+		};
+	}
+}
\ No newline at end of file
@@ -28,5 +28,9 @@
 #include <condition_variable>
 #include <atomic>
 #include <queue>
+#include <future>
+#include <unordered_map>
 #include <chrono>
-#include <ctime>
\ No newline at end of file
+#include <ctime>
+#include <cmath>
+#include <intrin.h>
\ No newline at end of file